@@ -8,17 +8,35 @@
 #include <cmath>
 #include <ctime>
 #include <sstream>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/time.h>
 
 #include "Tools.h"
 #include "Coverage.h"
 
 #ifdef DO_COVERAGE
 
+namespace {
+  // wall clock in seconds
+  double wallTime() {
+    struct timeval tv;
+    gettimeofday(&tv,0);
+    return double(tv.tv_sec) + 1e-6*double(tv.tv_usec);
+  }
+};
+
 Coverage::Coverage() {
   m_doneOneLoop = false;
   m_pole = 0;
   m_nLoops = 1;
   m_fixedSig = false;
+  m_exact    = false;
+  m_nExperiments = 0;
+  m_nThreads  = 1;
+  m_chunkSize = 0;
+  m_usedTime  = -1.0;
+  pthread_mutex_init(&m_lock,0);
 
   // set various pointers to 0
   resetCoverage();
@@ -26,6 +44,7 @@ Coverage::Coverage() {
 }
 
 Coverage::~Coverage() {
+  pthread_mutex_destroy(&m_lock);
 }
 
 void Coverage::setSeed(unsigned int r) {
@@ -230,7 +249,7 @@ void Coverage::outputCoverageResult(const int flag) { //output coverage result
   TOOLS::coutFixed(6,m_errCoverage); std::cout << "    ";
   TOOLS::coutFixed(6,m_totalCount); std::cout << "    ";
   TOOLS::coutFixed(6,m_nLoops); std::cout << "      ";
-  TOOLS::coutFixed(2,m_timer.getUsedClock()); std::cout << std::endl;
+  TOOLS::coutFixed(2,(m_usedTime<0 ? m_timer.getUsedClock():m_usedTime)); std::cout << std::endl;
 }
 
 
@@ -491,6 +510,13 @@ void Coverage::printSetup() {
   std::cout << "\n";
   std::cout << "==============C O V E R A G E=================\n";
   std::cout << " Random seed        : " << m_rndSeed << std::endl;
+  if (m_pole->getRndGen()) {
+    std::cout << " Uniform generator  : "
+              << TOOLS::boolChar(m_pole->getRndGen()->getEngine()==RND::RNG_XOSHIRO,"xoshiro256**","LCG")
+              << (m_nThreads!=1 ? " (threads: xoshiro256** substreams)":"") << std::endl;
+    std::cout << " Gauss generator    : "
+              << TOOLS::boolChar(m_pole->getRndGen()->getGaussAlg()==RND::GAUSS_ZIGGURAT,"Ziggurat","Box-Muller") << std::endl;
+  }
   std::cout << " Number of loops    : " << m_nLoops << std::endl;
   std::cout << " Collect statistics : " << TOOLS::yesNo(m_collectStats) << std::endl;
   std::cout << "----------------------------------------------\n";
@@ -499,6 +525,8 @@ void Coverage::printSetup() {
   std::cout << " Signal step        : " << m_sTrue.step() << std::endl;
   std::cout << " Signal N           : " << m_sTrue.n() << std::endl;
   std::cout << " Signal fixed       : " << TOOLS::yesNo(m_fixedSig) << std::endl;
+  std::cout << " Exact coverage     : " << TOOLS::yesNo(m_exact) << std::endl;
+  std::cout << " Threads            : " << m_nThreads << std::endl;
   std::cout << "----------------------------------------------\n";
   std::cout << " Efficiency min     : " << m_effTrue.min() << std::endl;
   std::cout << " Efficiency max     : " << m_effTrue.max() << std::endl;
@@ -525,6 +553,20 @@ void Coverage::doLoop() {
   m_doneOneLoop = false;
   if (m_pole==0) return;
   //
+  // With constant eff and bkg, the coverage can be calculated exactly
+  //
+  if (m_exact) {
+    if (m_pole->hasConstNuisances()) {
+      doExactLoop();
+      return;
+    }
+    std::cout << "WARNING: exact coverage requires constant efficiency and background - generating experiments." << std::endl;
+  }
+  if (m_nThreads!=1) {
+    doThreadedLoop();
+    return;
+  }
+  //
   //
   // Number of loops to time for an estimate of the total time
   //  int nest = (m_nLoops>100 ? 100:(m_nLoops>10 ? 10:1));
@@ -546,6 +588,10 @@ void Coverage::doLoop() {
   // Start timer
   //
   m_timer.startClock();
+  m_metrics.start();
+  m_nExperiments = 0;
+  int ipoint = 0;
+  const int npoints = m_sTrue.n()*m_effTrue.n()*m_bkgTrue.n();
   //
   for (is=0; is<m_sTrue.n(); is++) { // loop over all s_true
     m_pole->setTrueSignal( m_sTrue.getVal(is) );
@@ -604,6 +650,8 @@ void Coverage::doLoop() {
 	  }
           m_pole->setEffPdfMean( m_effTrue.getVal(ie) );
           m_pole->setBkgPdfMean( m_bkgTrue.getVal(ib) );
+          m_nExperiments++;
+          if (m_metrics.isDue()) writeMetrics(ipoint,npoints,j+1);
 	}
 	calcCoverage();         // calculate coverage and its uncertainty
         m_timer.stopClock();
@@ -611,9 +659,14 @@ void Coverage::doLoop() {
 	calcStatistics();       // dito for the statistics...
 	printStatistics();
 	dumpExperiments();
+        ipoint++;
       }
     }
   }
+  writeMetrics(npoints-1,npoints,m_nLoops,true);
+  LIMITS::PoleStat stat;
+  m_pole->getStat(stat);
+  stat.printTabStat();
   double frate = (nTotal>0 ? double(nWarnings)/double(nTotal):0.0);
   std::cout << ">>>Limit calculation failure rate: " << frate << std::endl;
   if (frate>0.01) {
@@ -726,6 +779,404 @@ void Coverage::doLoop() {
 //   //  printClockUsage(m_nLoops*m_sTrue.n()*m_effTrue.n()*m_bkgTrue.n());
 // }
 
+void Coverage::doExactLoop() {
+  //
+  // Calculates the coverage without generating any experiments.
+  // Valid only for constant efficiency and background; then the observed
+  // eff and bkg equal the truth and the only fluctuating quantity is N(obs).
+  // See Pole::calcExactCoverage().
+  //
+  m_doneOneLoop = false;
+  if (m_pole==0) return;
+  if (!m_pole->hasConstNuisances()) {
+    std::cout << "ERROR: exact coverage requires constant efficiency and background!" << std::endl;
+    return;
+  }
+  int is,ie,ib;
+  //
+  m_timer.startClock();
+  m_metrics.start();
+  m_nExperiments = 0;
+  int ipoint = 0;
+  const int npoints = m_sTrue.n()*m_effTrue.n()*m_bkgTrue.n();
+  //
+  for (is=0; is<m_sTrue.n(); is++) { // loop over all s_true
+    m_pole->setTrueSignal( m_sTrue.getVal(is) );
+    for (ie=0; ie<m_effTrue.n(); ie++) { // loop over eff true
+      for (ib=0; ib<m_bkgTrue.n(); ib++) { // loop over bkg true
+        m_pole->setEffPdfMean( m_effTrue.getVal(ie) );
+        m_pole->setBkgPdfMean( m_bkgTrue.getVal(ib) );
+        m_pole->setEffObs();
+        m_pole->setBkgObs();
+        //
+        resetCoverage();
+        m_timer.startClock();
+        m_pole->initAnalysis();
+        m_coverage    = m_pole->calcExactCoverage();
+        m_errCoverage = 0.0;
+        m_doneOneLoop = true;
+        m_timer.stopClock();
+        outputCoverageResult(); // print the result
+        m_nExperiments++;
+        if (m_metrics.isDue()) writeMetrics(ipoint,npoints,1);
+        ipoint++;
+      }
+    }
+  }
+  writeMetrics(npoints-1,npoints,1,true);
+  m_timer.printCurrentTime("\nEnd of run: ");
+}
+
+void Coverage::writeMetrics(int ipoint, int npoints, int iloop, bool done) {
+  //
+  // Writes the current throughput, grid point and Pole statistics to the metrics file.
+  // For an exact coverage run, one 'experiment' corresponds to one grid point.
+  //
+  if ((m_pole==0) || (!m_metrics.isActive())) return;
+  const double dt = m_metrics.getElapsed();
+  m_metrics.clear();
+  m_metrics.add("status",            (done ? "done":"running"));
+  m_metrics.add("experiments",       m_nExperiments);
+  m_metrics.add("experiments_per_s", (dt>0 ? double(m_nExperiments)/dt : 0.0));
+  m_metrics.add("grid_point",        ipoint+1);
+  m_metrics.add("grid_points",       npoints);
+  m_metrics.add("s_true",            m_pole->getTrueSignal());
+  m_metrics.add("eff_true",          m_pole->getEffPdfMean());
+  m_metrics.add("bkg_true",          m_pole->getBkgPdfMean());
+  m_metrics.add("loop",              iloop);
+  m_metrics.add("nloops",            m_nLoops);
+  m_pole->addMetrics(m_metrics);
+  m_metrics.write();
+}
+
+void Coverage::doThreadedLoop() {
+  //
+  // Same as doLoop() but the experiments are distributed over several threads.
+  //
+  // Each grid point (s,eff,bkg) is split into chunks of experiments (tasks).
+  // The tasks are dealt to the workers in order of decreasing estimated cost.
+  // A worker always takes the most expensive task in its own queue; when empty it
+  // steals the most expensive task from the worker with the most remaining work.
+  // The cost per experiment is modelled as (1 + lambda) with lambda = eff*s + bkg,
+  // and is replaced by the measured time as soon as a chunk of the point is done.
+  //
+  // The random seed of each chunk depends only on the main seed, the point and the chunk,
+  // hence the result does not depend on the scheduling.
+  // NOTE: collecting statistics is not supported.
+  //
+  m_doneOneLoop = false;
+  if (m_pole==0) return;
+  int nThreads = m_nThreads;
+  if (nThreads<1) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    nThreads = (ncpu>0 ? static_cast<int>(ncpu):1);
+  }
+  if (m_collectStats) {
+    std::cout << "WARNING: statistics are not collected when running with threads." << std::endl;
+  }
+  //
+  // Grid points
+  //
+  m_points.clear();
+  for (int is=0; is<m_sTrue.n(); is++) {
+    for (int ie=0; ie<m_effTrue.n(); ie++) {
+      for (int ib=0; ib<m_bkgTrue.n(); ib++) {
+        COVERAGE::Point p;
+        p.s   = m_sTrue.getVal(is);
+        p.eff = m_effTrue.getVal(ie);
+        p.bkg = m_bkgTrue.getVal(ib);
+        p.model = 1.0 + m_pole->getEffScale()*p.eff*p.s + m_pole->getBkgScale()*p.bkg;
+        p.nChunks = 0;
+        p.nChunksDone = 0;
+        p.inside = 0;
+        p.total  = 0;
+        p.failed = 0;
+        p.time   = 0;
+        m_points.push_back(p);
+      }
+    }
+  }
+  const int npoints = static_cast<int>(m_points.size());
+  //
+  // Chunks - by default aim at >= 4 tasks per thread
+  //
+  int chunkSize = m_chunkSize;
+  if (chunkSize<1) {
+    int nChunks = (4*nThreads + npoints - 1)/npoints;
+    chunkSize = (m_nLoops + nChunks - 1)/nChunks;
+  }
+  if (chunkSize<1) chunkSize = 1;
+  std::vector<COVERAGE::Task> tasks;
+  for (int ip=0; ip<npoints; ip++) {
+    int nleft = m_nLoops;
+    int chunk = 0;
+    while (nleft>0) {
+      COVERAGE::Task t;
+      t.point  = ip;
+      t.chunk  = chunk++;
+      t.nloops = (nleft<chunkSize ? nleft:chunkSize);
+      nleft   -= t.nloops;
+      tasks.push_back(t);
+    }
+    m_points[ip].nChunks = chunk;
+  }
+  //
+  // Workers - the setup is done here, before starting the threads
+  //
+  m_modelDone  = 0;
+  m_timeDone   = 0;
+  m_nextOutput = 0;
+  m_nWarnings  = 0;
+  m_nExperiments = 0;
+  m_pole->setUseCoverage(true);
+  for (int i=0; i<nThreads; i++) {
+    COVERAGE::Worker *w = new COVERAGE::Worker;
+    w->index    = i;
+    w->coverage = this;
+    w->pole.initDefault();
+    w->pole.copySetup(*m_pole);
+    // the engine is xoshiro in any case, see runTask() and Random::setSubstream()
+    if (m_pole->getRndGen()) w->rnd.setGaussAlg(m_pole->getRndGen()->getGaussAlg());
+    w->pole.setRndGen(&w->rnd); // initAnalysis() is done per experiment, see runTask()
+    m_workers.push_back(w);
+  }
+  //
+  // deal the tasks in order of decreasing cost
+  //
+  std::vector< std::pair<double,int> > cost(tasks.size());
+  for (size_t i=0; i<tasks.size(); i++) cost[i] = std::make_pair(-taskCost(tasks[i]),int(i));
+  std::sort(cost.begin(),cost.end());
+  for (size_t i=0; i<cost.size(); i++) {
+    m_workers[i%nThreads]->tasks.push_back(tasks[cost[i].second]);
+  }
+  std::cout << "Running " << tasks.size() << " tasks of max " << chunkSize
+            << " experiments on " << nThreads << " threads" << std::endl;
+  //
+  m_timer.start();
+  m_metrics.start();
+  for (int i=0; i<nThreads; i++) {
+    if (pthread_create(&(m_workers[i]->thread), 0, &Coverage::runWorker, m_workers[i])!=0) {
+      std::cerr << "FATAL: failed to create thread " << i << std::endl;
+      exit(-1);
+    }
+  }
+  //
+  // wait until all points are done - meanwhile update metrics
+  //
+  bool done = false;
+  while (!done) {
+    sleep(1);
+    pthread_mutex_lock(&m_lock);
+    done = (m_nextOutput==npoints);
+    pthread_mutex_unlock(&m_lock);
+    if ((!done) && m_metrics.isDue()) writeThreadMetrics();
+  }
+  for (int i=0; i<nThreads; i++) {
+    pthread_join(m_workers[i]->thread,0);
+  }
+  m_timer.stop();
+  writeThreadMetrics(true);
+  //
+  LIMITS::PoleStat stat;
+  for (int i=0; i<nThreads; i++) stat.add(m_workers[i]->stat);
+  stat.printTabStat();
+  //
+  int nFailed = 0;
+  int nTotal  = 0;
+  for (int ip=0; ip<npoints; ip++) {
+    nFailed += m_points[ip].failed;
+    nTotal  += m_points[ip].failed + m_points[ip].total;
+  }
+  for (int i=0; i<nThreads; i++) delete m_workers[i];
+  m_workers.clear();
+  //
+  double frate = (nTotal>0 ? double(nFailed)/double(nTotal):0.0);
+  std::cout << ">>>Limit calculation failure rate: " << frate << std::endl;
+  if (frate>0.01) {
+    std::cout << "WARNING: The failure rate in the limit calculations is large (>0.01)." << std::endl;
+  }
+  m_timer.printUsedTime("Wall time used: ");
+  m_timer.printCurrentTime("\nEnd of run: ");
+}
+
+void *Coverage::runWorker(void *worker) {
+  COVERAGE::Worker *w = static_cast<COVERAGE::Worker *>(worker);
+  COVERAGE::Task task;
+  while (w->coverage->nextTask(w,task)) {
+    w->coverage->runTask(w,task);
+  }
+  return 0;
+}
+
+double Coverage::taskCost(const COVERAGE::Task & task) const {
+  // estimated cost of a task - call with m_lock held (or before starting threads)
+  const COVERAGE::Point & p = m_points[task.point];
+  double perExp;
+  int ndone = p.total + p.failed;
+  if (ndone>0) {
+    perExp = p.time/double(ndone);                 // measured
+  } else if (m_modelDone>0) {
+    perExp = p.model*(m_timeDone/m_modelDone);     // model, calibrated on the finished points
+  } else {
+    perExp = p.model;                              // model only
+  }
+  return perExp*double(task.nloops);
+}
+
+bool Coverage::nextTask(COVERAGE::Worker *worker, COVERAGE::Task & task) {
+  //
+  // Take the most expensive task from the own queue or, if empty, steal one from
+  // the worker with the most remaining work.
+  // The tasks are coarse (many experiments) so a single lock is sufficient.
+  //
+  pthread_mutex_lock(&m_lock);
+  COVERAGE::Worker *victim = worker;
+  if (worker->tasks.empty()) {
+    victim = 0;
+    double maxWork = 0;
+    for (size_t i=0; i<m_workers.size(); i++) {
+      double work = 0;
+      for (size_t j=0; j<m_workers[i]->tasks.size(); j++) work += taskCost(m_workers[i]->tasks[j]);
+      if ((!m_workers[i]->tasks.empty()) && ((victim==0) || (work>maxWork))) {
+        victim  = m_workers[i];
+        maxWork = work;
+      }
+    }
+  }
+  bool found = (victim!=0);
+  if (found) {
+    std::deque<COVERAGE::Task>::iterator best = victim->tasks.begin();
+    double maxCost = taskCost(*best);
+    for (std::deque<COVERAGE::Task>::iterator it=victim->tasks.begin(); it!=victim->tasks.end(); ++it) {
+      double c = taskCost(*it);
+      if (c>maxCost) {
+        maxCost = c;
+        best    = it;
+      }
+    }
+    task = *best;
+    victim->tasks.erase(best);
+  }
+  pthread_mutex_unlock(&m_lock);
+  return found;
+}
+
+void Coverage::runTask(COVERAGE::Worker *worker, const COVERAGE::Task & task) {
+  const int maxWarnings=10;
+  LIMITS::Pole *pole = &(worker->pole);
+  double eff, bkg;
+  //
+  pthread_mutex_lock(&m_lock);
+  const COVERAGE::Point & point = m_points[task.point];
+  pole->setTrueSignal( point.s );
+  eff = point.eff;
+  bkg = point.bkg;
+  pthread_mutex_unlock(&m_lock);
+  //
+  // substream for the chunk - independent of which thread runs it
+  worker->rnd.setSubstream( m_rndSeed, task.point, task.chunk );
+  pole->setEffPdfMean( eff );
+  pole->setBkgPdfMean( bkg );
+  //
+  int inside = 0;
+  int total  = 0;
+  int failed = 0;
+  double t0 = wallTime();
+  for (int j=0; j<task.nloops; j++) {
+    pole->generatePseudoExperiment();
+    pole->setEffPdfMean( pole->getEffObs() );
+    pole->setBkgPdfMean( pole->getBkgObs() );
+    pole->initAnalysis();
+    if (!pole->analyseExperiment()) {
+      failed++;
+      pthread_mutex_lock(&m_lock);
+      if (m_nWarnings<maxWarnings) {
+        pole->printFailureMsg();
+        pole->getMeasurement().dump();
+        std::cout << "s(true) = " << pole->getTrueSignal() << std::endl;
+        std::cout << "Pseudoexperiment will be ignored!" << std::endl;
+        if (m_nWarnings==maxWarnings-1) {
+          std::cout << "WARNING: previous message will not be repeated." << std::endl;
+        }
+      }
+      m_nWarnings++;
+      pthread_mutex_unlock(&m_lock);
+    } else {
+      total++;
+      if (pole->truthCovered()) inside++;
+    }
+    pole->setEffPdfMean( eff );
+    pole->setBkgPdfMean( bkg );
+  }
+  double dt = wallTime()-t0;
+  //
+  // store the result and output all finished points in grid order
+  //
+  pthread_mutex_lock(&m_lock);
+  COVERAGE::Point & p = m_points[task.point];
+  p.inside += inside;
+  p.total  += total;
+  p.failed += failed;
+  p.time   += dt;
+  p.nChunksDone++;
+  m_modelDone    += p.model*double(task.nloops);
+  m_timeDone     += dt;
+  m_nExperiments += task.nloops;
+  pole->getStat(worker->stat);
+  while ((m_nextOutput<static_cast<int>(m_points.size())) &&
+         (m_points[m_nextOutput].nChunksDone==m_points[m_nextOutput].nChunks)) {
+    const COVERAGE::Point & op = m_points[m_nextOutput];
+    m_pole->setTrueSignal( op.s );
+    m_pole->setEffPdfMean( op.eff );
+    m_pole->setBkgPdfMean( op.bkg );
+    m_insideCount = op.inside;
+    m_totalCount  = op.total;
+    m_usedTime    = op.time*1000.0;
+    m_doneOneLoop = (op.total>0);
+    calcCoverage();
+    outputCoverageResult();
+    m_usedTime    = -1.0;
+    m_nextOutput++;
+  }
+  pthread_mutex_unlock(&m_lock);
+}
+
+void Coverage::writeThreadMetrics(bool done) {
+  //
+  // metrics for the threaded loop - the pole statistics are summed over all workers
+  //
+  if ((m_pole==0) || (!m_metrics.isActive())) return;
+  const double dt = m_metrics.getElapsed();
+  LIMITS::PoleStat stat;
+  pthread_mutex_lock(&m_lock);
+  int ntasks = 0;
+  for (size_t i=0; i<m_workers.size(); i++) {
+    stat.add(m_workers[i]->stat);
+    ntasks += m_workers[i]->tasks.size();
+  }
+  const int npoints = static_cast<int>(m_points.size());
+  const int ip = (m_nextOutput<npoints ? m_nextOutput:npoints-1);
+  m_metrics.clear();
+  m_metrics.add("status",            (done ? "done":"running"));
+  m_metrics.add("threads",           m_workers.size());
+  m_metrics.add("tasks_queued",      ntasks);
+  m_metrics.add("experiments",       m_nExperiments);
+  m_metrics.add("experiments_per_s", (dt>0 ? double(m_nExperiments)/dt : 0.0));
+  m_metrics.add("grid_point",        ip+1);
+  m_metrics.add("grid_points",       npoints);
+  if (ip>=0) {
+    m_metrics.add("s_true",          m_points[ip].s);
+    m_metrics.add("eff_true",        m_points[ip].eff);
+    m_metrics.add("bkg_true",        m_points[ip].bkg);
+    m_metrics.add("loop",            m_points[ip].total+m_points[ip].failed);
+  }
+  m_metrics.add("nloops",            m_nLoops);
+  pthread_mutex_unlock(&m_lock);
+  stat.addMetrics(m_metrics);
+  m_pole->addPoissonMetrics(m_metrics);
+  m_metrics.write();
+}
+
 void Coverage::doExpTest() {
   //
   if (m_pole==0) return;
@@ -13,10 +13,48 @@
 #include <cmath>
 #include <ctime>
 #include <string>
+#include <deque>
+#include <pthread.h>
 
 #include "Range.h"
 #include "Random.h"
 #include "Pole.h"
+
+class Coverage;
+
+namespace COVERAGE {
+  //
+  // Used by the threaded loop, Coverage::doThreadedLoop()
+  //
+  //! a chunk of pseudo-experiments at one grid point
+  struct Task {
+    int point;  // index of grid point
+    int chunk;  // chunk index within the point - defines the random seed
+    int nloops; // number of experiments
+  };
+  //! a grid point (s,eff,bkg) and its accumulated results
+  struct Point {
+    double s, eff, bkg;
+    double model;       // cost model, relative cost per experiment
+    int    nChunks;     // number of chunks
+    int    nChunksDone; // finished chunks
+    int    inside;      // experiments with s(true) inside the limits
+    int    total;       // successful experiments
+    int    failed;      // failed experiments
+    double time;        // wall time (s) used by finished chunks
+  };
+  //! one worker thread with its own Pole, random generator and task queue
+  struct Worker {
+    int                 index;
+    pthread_t           thread;
+    Coverage           *coverage;
+    LIMITS::Pole        pole;
+    RND::Random         rnd;
+    std::deque<Task>    tasks;
+    LIMITS::PoleStat    stat; // copy of pole statistics, updated after each chunk
+  };
+};
+
 class Coverage {
 public:
   Coverage();
@@ -32,10 +70,16 @@ public:
   void setEffTrue(double emin, double emax, double step);
   void setBkgTrue(double bmin, double bmax, double step);
   void setFixedSig(bool flag)  { m_fixedSig  = flag;}
+  void setExact(bool flag)     { m_exact     = flag;} // exact coverage if eff and bkg are constant
   //
   void printSetup();
   void doLoop();               // loops over all requested 'experiments'
   void doExpTest();            // loops over all requested 'experiments', no limit calc
+  void doExactLoop();          // exact coverage, no pseudo-experiments - requires constant eff and bkg
+  void doThreadedLoop();       // as doLoop() but using setNThreads() threads
+  //
+  void setNThreads(int n)  { m_nThreads  = n; }            // number of threads; <1 => number of cpus
+  void setChunkSize(int n) { m_chunkSize = (n<0 ? 0:n); }  // experiments per task; 0 => automatic
   //
   void updateCoverage();	// Update coverage counters
   void resetCoverage();		// Reset dito
@@ -57,14 +101,26 @@ public:
   void dumpExperiments(bool dumpLimits=true);
   void calcCoverage();		// Calculate coverage
   virtual void outputCoverageResult(const int flag=0);	// Output coverage
+  double getCoverage()    const { return m_coverage; }    // result of calcCoverage()
+  double getErrCoverage() const { return m_errCoverage; }
   //
   void setVerbose(int v=0) { m_verbose = v; }
+  // metrics file updated every dt seconds during the loop - no file if name is empty
+  void setMetricsFile(const char *name, int dt=30) { m_metrics.setFileName(name); m_metrics.setInterval(dt); }
 
   bool doneOneLoop() { return m_doneOneLoop; }
   //
 private:
   void calcStats(std::vector<double> & vec, double & average, double & variance);
   double calcStatsCorr(std::vector<double> & x, std::vector<double> & y);
+  void writeMetrics(int ipoint, int npoints, int iloop, bool done=false);
+  //
+  // threaded loop
+  static void *runWorker(void *worker);
+  bool   nextTask(COVERAGE::Worker *worker, COVERAGE::Task & task);
+  void   runTask(COVERAGE::Worker *worker, const COVERAGE::Task & task);
+  double taskCost(const COVERAGE::Task & task) const;
+  void   writeThreadMetrics(bool done=false);
   //
   int    m_verbose;
   //
@@ -82,6 +138,19 @@ private:
   bool   m_fixedEff;
   bool   m_fixedBkg;
   bool   m_fixedSig;
+  // if true and eff,bkg are constant, calculate the exact coverage instead of generating experiments
+  bool   m_exact;
+  // threads
+  int    m_nThreads;   // number of threads
+  int    m_chunkSize;  // experiments per task
+  std::vector<COVERAGE::Point>    m_points;  // grid points
+  std::vector<COVERAGE::Worker *> m_workers; // workers
+  pthread_mutex_t m_lock;       // protects tasks, points, cost model and output
+  int    m_nextOutput;          // next point to output - points are printed in grid order
+  int    m_nWarnings;           // number of printed failure warnings
+  double m_modelDone;           // sum of model cost for all finished experiments
+  double m_timeDone;            // wall time used by idem
+  double m_usedTime;            // time [ms] in outputCoverageResult() - if <0, use m_timer
   //
   bool   m_isInside;
   int    m_insideCount;
@@ -121,6 +190,9 @@ private:
   bool   m_doneOneLoop;
   // some timing stuff
   TOOLS::Timer m_timer;
+  // progress metrics
+  TOOLS::MetricsFile m_metrics;
+  int                m_nExperiments; // number of experiments analysed in the current loop
 };
 #endif
 
@@ -0,0 +1,145 @@
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+#include <cmath>
+#include <cfloat>
+#include <cstddef>
+
+/*!
+  Array versions of exp() and log(), used by the batch evaluation of the pdfs.
+
+  Without USE_SIMD, they simply loop over std::exp() and std::log().
+  With USE_SIMD (make USE_SIMD=avx2 or avx512), branch free polynomial kernels are used.
+  These are written such that the compiler vectorizes the loops.
+  The relative precision is better than 1e-15.
+  Results below DBL_MIN (denormals) are flushed to zero by vexp().
+ */
+namespace FMATH {
+  //! y[i] = exp(x[i]), i=0..n-1 ; x and y may be the same array
+  inline void vexp(const double *x, double *y, const size_t n);
+  //! y[i] = log(x[i]), i=0..n-1 ; x and y may be the same array
+  inline void vlog(const double *x, double *y, const size_t n);
+
+#ifdef USE_SIMD
+  namespace KERNEL {
+    const double LOG2E  = 1.4426950408889634074;
+    const double LN2HI  = 6.93147180369123816490e-01; // ln(2), upper bits
+    const double LN2LO  = 1.90821492927058770002e-10; // ln(2), remainder
+    const double SHIFT  = 6755399441055744.0;        // 1.5*2^52 - rounds to nearest integer
+    const double XMAX   = 709.782712893383973096;    // exp(XMAX) = DBL_MAX
+    const double XTOP   = 709.4;                     // max x for the kernel: k <= 1023
+    const double XMIN   = -708.396418532264106224;   // exp(XMIN) = DBL_MIN
+    const double SQRT2  = 1.41421356237309504880;
+
+    // type punning through a union - supported by gcc, and unlike memcpy() it does not stop vectorization
+    union Bits { double d; unsigned long long i; };
+    inline double asDouble(unsigned long long i) { Bits b; b.i = i; return b.d; }
+    inline unsigned long long asInt(double d)    { Bits b; b.d = d; return b.i; }
+
+    //! exp(x) for XMIN <= x <= XTOP
+    inline double exp(double x) {
+      // x = k*ln2 + r, |r| <= ln2/2
+      const double kd = x*LOG2E + SHIFT;
+      const double k  = kd - SHIFT;
+      const double r  = (x - k*LN2HI) - k*LN2LO;
+      // exp(r) - Taylor to 13th order
+      double p = 1.0/6227020800.0;
+      p = p*r + 1.0/479001600.0;
+      p = p*r + 1.0/39916800.0;
+      p = p*r + 1.0/3628800.0;
+      p = p*r + 1.0/362880.0;
+      p = p*r + 1.0/40320.0;
+      p = p*r + 1.0/5040.0;
+      p = p*r + 1.0/720.0;
+      p = p*r + 1.0/120.0;
+      p = p*r + 1.0/24.0;
+      p = p*r + 1.0/6.0;
+      p = p*r + 0.5;
+      p = p*r + 1.0;
+      p = p*r + 1.0;
+      // 2^k - the low bits of kd contain k
+      const unsigned long long e = (asInt(kd) + 1023ULL) << 52;
+      return p*asDouble(e);
+    }
+
+    //! log(x) for normal x>0
+    inline double log(double x) {
+      // x = m*2^e, 1 <= m < 2
+      const unsigned long long bits = asInt(x);
+      // exponent as double without an integer conversion: (2^52 + ebits) - 2^52 - 1023
+      double e = asDouble((bits >> 52) | 0x4330000000000000ULL) - (4503599627370496.0 + 1023.0);
+      double m = asDouble((bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+      // sqrt(2)/2 <= m < sqrt(2)
+      e = (m>SQRT2 ? e+1.0 : e);
+      m = (m>SQRT2 ? 0.5*m : m);
+      // log(m) = 2*atanh(f), f = (m-1)/(m+1), |f| < 0.172
+      const double f = (m-1.0)/(m+1.0);
+      const double s = f*f;
+      double p = 1.0/23.0;
+      p = p*s + 1.0/21.0;
+      p = p*s + 1.0/19.0;
+      p = p*s + 1.0/17.0;
+      p = p*s + 1.0/15.0;
+      p = p*s + 1.0/13.0;
+      p = p*s + 1.0/11.0;
+      p = p*s + 1.0/9.0;
+      p = p*s + 1.0/7.0;
+      p = p*s + 1.0/5.0;
+      p = p*s + 1.0/3.0;
+      p = p*s + 1.0;
+      return e*LN2HI + (2.0*f*p + e*LN2LO);
+    }
+  };
+
+  //! points per block - the values outside the kernel range are saved per block, before y is written
+  const size_t VBLOCK = 64;
+
+  inline void vexp(const double *x, double *y, const size_t n) {
+    double xs[VBLOCK];
+    size_t is[VBLOCK];
+    for (size_t i0=0; i0<n; i0+=VBLOCK) {
+      const size_t nb = (n-i0<VBLOCK ? n-i0 : VBLOCK);
+      // x > XTOP and NaN are not handled by the kernel
+      size_t ns = 0;
+      for (size_t i=i0; i<i0+nb; i++) {
+        if (!(x[i]<=KERNEL::XTOP)) { is[ns] = i; xs[ns++] = x[i]; }
+      }
+      for (size_t i=i0; i<i0+nb; i++) {
+        const double xi = x[i];
+        const double xl = (xi<KERNEL::XMIN ? KERNEL::XMIN : xi);
+        const double v  = KERNEL::exp(xl>KERNEL::XTOP ? KERNEL::XTOP : xl);
+        y[i] = (xi<KERNEL::XMIN ? 0.0 : v);
+      }
+      for (size_t k=0; k<ns; k++) y[is[k]] = std::exp(xs[k]);
+    }
+  }
+
+  inline void vlog(const double *x, double *y, const size_t n) {
+    double xs[VBLOCK];
+    size_t is[VBLOCK];
+    for (size_t i0=0; i0<n; i0+=VBLOCK) {
+      const size_t nb = (n-i0<VBLOCK ? n-i0 : VBLOCK);
+      // zero, negative, denormal, inf and NaN
+      size_t ns = 0;
+      for (size_t i=i0; i<i0+nb; i++) {
+        if (!((x[i]>=DBL_MIN) && (x[i]<=DBL_MAX))) { is[ns] = i; xs[ns++] = x[i]; }
+      }
+      for (size_t i=i0; i<i0+nb; i++) {
+        const double xi = x[i];
+        const double xl = (xi<DBL_MIN ? 1.0 : xi);
+        y[i] = KERNEL::log(xl>DBL_MAX ? 1.0 : xl);
+      }
+      for (size_t k=0; k<ns; k++) y[is[k]] = std::log(xs[k]);
+    }
+  }
+#else
+  inline void vexp(const double *x, double *y, const size_t n) {
+    for (size_t i=0; i<n; i++) y[i] = std::exp(x[i]);
+  }
+  inline void vlog(const double *x, double *y, const size_t n) {
+    for (size_t i=0; i<n; i++) y[i] = std::log(x[i]);
+  }
+#endif
+};
+
+#endif
@@ -7,6 +7,13 @@
 #include <cstdlib>
 #include <string>
 
+//! one line of the banded storage, see ITabulator::setTabStorage()
+struct TabBandLine {
+   int    lo;  /**< first node of the band */
+   int    hi;  /**< last node of the band + 1 */
+   size_t off; /**< index in the band values of node 0 of the line, i.e. of node j at off+j (modulo 2^n) */
+};
+
 /*! @class ITabulator
 
   @brief Interface class to the Tabulator class
@@ -14,13 +21,40 @@
 */
 class ITabulator {
 public:
+   //! interpolation between the table nodes, see Tabulator<T>::getTabValue()
+   enum INTERP {
+      INTERP_DEFAULT=0, /*!< the interpolate() of the class */
+      INTERP_NEAREST,   /*!< nearest node */
+      INTERP_LINEAR,    /*!< multilinear, 2^d nodes */
+      INTERP_HERMITE,   /*!< tensor product cubic Hermite, finite difference slopes, 4^d nodes */
+      INTERP_TAYLOR     /*!< second order around the nearest node along the selected axes, 3 nodes each */
+   };
+   //! storage of the table values, see setTabStorage()
+   enum STORAGE {
+      STORE_DOUBLE=0,  /*!< dense, double */
+      STORE_FLOAT,     /*!< dense, float */
+      STORE_BAND,      /*!< per line along the last parameter in memory, the band of nodes with |f|>threshold - double */
+      STORE_BAND_FLOAT /*!< idem, float */
+   };
    //! main constructor
    inline ITabulator(const char *name, const char *desc=0) {
       if (name) m_name        = name;
       if (desc) m_description = desc;
+      clrStat();
+      m_interp     = INTERP_DEFAULT;
+      m_taylorAxes = ~0u;
+      m_growth     = 0.0;
+      m_growMaxSize    = 0;
+      m_growCredit     = 0;
+      m_warnedFallback = false;
+      m_derivAxis      = -1;
+      m_tabStorage     = STORE_DOUBLE;
+      m_bandThreshold  = 0.0;
+      m_bandAxis       = 0;
    }
    //! empty constructor
-   inline ITabulator() {}
+   inline ITabulator() { clrStat(); m_interp = INTERP_DEFAULT; m_taylorAxes = ~0u; m_growth = 0.0; m_growMaxSize = 0; m_growCredit = 0; m_warnedFallback = false; m_derivAxis = -1;
+                         m_tabStorage = STORE_DOUBLE; m_bandThreshold = 0.0; m_bandAxis = 0; }
    //! destructor
    inline virtual ~ITabulator() {}
 
@@ -45,6 +79,11 @@ public:
    virtual void setVerbose(bool v) = 0;
    //! do the tabulation
    virtual void tabulate() = 0;
+   /*!
+     Extend the table upwards such that it includes the given parameters, adding at most maxAdd nodes.
+     Only the new nodes are calculated. Returns false if not possible, see setGrowth().
+   */
+   virtual bool extendTable( const std::vector<double> & tabParams, size_t maxAdd=~static_cast<size_t>(0) ) = 0;
    //! get the tabulated value with the given parameter vector
    virtual double getValue( const std::vector<double> & tabParams ) = 0;
    //! idem for one parameter
@@ -62,10 +101,108 @@ public:
    virtual double getTabMax( size_t pind ) const = 0;
    virtual double getTabStep( size_t pind ) const = 0;
    virtual size_t getTabNsteps( size_t pind ) const = 0;
+   //! the table - read only ; empty if not stored as double, see setTabStorage()
+   inline const std::vector<double> & getTabValues() const { return m_tabValues; }
+   //! number of nodes
+   inline size_t getTabSize() const { return m_tabSize; }
+   /*!
+     Order of the parameters in memory, slowest varying first - the last one has stride 1.
+     Default (empty) is the parameter order. Takes effect at the next tabulate().
+     Choose the parameter scanned in the inner loops of the user as the last one.
+   */
+   inline bool setTabAxisOrder( const std::vector<size_t> & order ) {
+      std::vector<bool> used(order.size(),false);
+      for (size_t i=0; i<order.size(); i++) {
+         if ((order[i]>=order.size()) || used[order[i]]) {
+            std::cout << "ERROR: " << m_name << " : axis order is not a permutation - ignored" << std::endl;
+            return false;
+         }
+         used[order[i]] = true;
+      }
+      m_tabOrder = order;
+      return true;
+   }
+   inline const std::vector<size_t> & getTabAxisOrder() const { return m_tabOrder; }
+   //! the derivative table, see setDerivAxis() - read only
+   inline const std::vector<double> & getTabDerivs() const { return m_tabDerivs; }
 
    //! check if the table is ok
    virtual bool isTabulated() const = 0;
 
+   /*! @name Interpolation */
+   //@{
+   //! select the interpolation ; taylorAxes: bit i set => INTERP_TAYLOR along parameter i
+   inline void setInterpolation( INTERP interp, unsigned int taylorAxes=~0u ) { m_interp = interp; m_taylorAxes = taylorAxes; }
+   inline INTERP       getInterpolation() const { return m_interp; }
+   inline unsigned int getTaylorAxes()    const { return m_taylorAxes; }
+   /*!
+     If pind>=0, tabulate() also makes a table with f, df/dx and d2f/dx2 along parameter pind,
+     stored next to each other per node. Used by getTabValue() and TabulatorFixed for the Taylor
+     and Hermite interpolation along pind, which then read one node (resp. two neighbouring nodes).
+     The derivatives are 4th order finite differences (2nd order near the ends).
+   */
+   inline void setDerivAxis( int pind ) { m_derivAxis = pind; }
+   inline int  getDerivAxis() const { return m_derivAxis; }
+   //@}
+
+   /*! @name Storage */
+   //@{
+   /*!
+     Storage of the values, takes effect at the next tabulate(). Except for STORE_DOUBLE,
+     the table is made in double as usual, converted, and the double table is released.
+     The banded storage keeps, for each line along the last parameter in memory (see setTabAxisOrder()),
+     the nodes from the first to the last one with |f|>threshold ; the nodes outside read as 0.
+     For a pdf with one peak along that parameter, this is about the width of the peak per line.
+     In float, values below ~1e-38 are 0 and the relative precision is ~6e-8.
+   */
+   inline void setTabStorage( STORAGE storage, double threshold=0.0 ) { m_tabStorage = storage; m_bandThreshold = threshold; }
+   inline STORAGE getTabStorage()       const { return m_tabStorage; }
+   inline double  getTabBandThreshold() const { return m_bandThreshold; }
+   //! the parameter along the lines of the banded storage
+   inline size_t  getTabBandAxis()      const { return m_bandAxis; }
+   //! the stored tables - read only
+   inline const std::vector<float>  & getTabFloat()      const { return m_tabFloat; }
+   inline const std::vector<TabBandLine> & getTabBandLines() const { return m_bandLines; }
+   inline const std::vector<double> & getTabBandValues() const { return m_bandValues; }
+   inline const std::vector<float>  & getTabBandFloat()  const { return m_bandFloat; }
+   //! memory used by the stored tables, in bytes
+   inline size_t getTabMemory() const {
+      return (m_tabValues.size()+m_tabDerivs.size()+m_bandValues.size())*sizeof(double)
+         + (m_tabFloat.size()+m_bandFloat.size())*sizeof(float)
+         + m_bandLines.size()*sizeof(TabBandLine);
+   }
+   //@}
+
+   /*! @name Growth */
+   //@{
+   /*!
+     If growth>0, getValue() may extend the table when a parameter is above its max.
+     Each extension adds max(1,growth*nsteps) steps beyond the one needed, up to a table of maxSize nodes.
+     The table is extended once the number of out-of-range calls since tabulate() reaches the number
+     of nodes to add - at most twice the cost of the best choice between extending and calculating.
+     Below min, the value is always calculated.
+   */
+   inline void setGrowth( double growth, size_t maxSize=(1<<20) ) { m_growth = growth; m_growMaxSize = maxSize; }
+   inline double getGrowth()        const { return m_growth; }
+   inline size_t getGrowthMaxSize() const { return m_growMaxSize; }
+   //@}
+
+   /*! @name Usage statistics */
+   //@{
+   //! clear statistics
+   inline void clrStat() { m_statNtabulate=0; m_statNlookup=0; m_statNfallback=0; m_statNdirect=0; m_statNextend=0; }
+   //! number of calls to tabulate()
+   inline unsigned long getStatNtabulate() const { return m_statNtabulate; }
+   //! number of values obtained from the table
+   inline unsigned long getStatNlookup()   const { return m_statNlookup; }
+   //! number of values calculated because the parameters were out of range
+   inline unsigned long getStatNfallback() const { return m_statNfallback; }
+   //! number of values calculated because the table was not yet made
+   inline unsigned long getStatNdirect()   const { return m_statNdirect; }
+   //! number of extensions by extendTable()
+   inline unsigned long getStatNextend()   const { return m_statNextend; }
+   //@}
+
 protected:
    //! set tabulated par
    virtual void setTabPar( const char *name, int index, double min, double max, double step, size_t nsteps, int parInd=-1 ) = 0;
@@ -104,6 +241,16 @@ protected:
    std::vector<size_t> m_tabPeriod;   /**< parameter period */
    std::vector<size_t> m_tabNTabSteps;/**< parameter: number of steps in table until next value tabNTabSteps = tabPeriod[i-1]  */
    std::vector<double> m_tabValues;   /**< the actual table */
+   std::vector<size_t> m_tabOrder;    /**< parameter order in memory, see setTabAxisOrder() */
+   int                 m_derivAxis;   /**< parameter of the derivative table, -1 if none */
+   std::vector<double> m_tabDerivs;   /**< f,f',f'' per node along m_derivAxis */
+   STORAGE             m_tabStorage;    /**< storage of the values, see setTabStorage() */
+   double              m_bandThreshold; /**< nodes with |f| above are kept in the banded storage */
+   size_t              m_bandAxis;      /**< banded storage: parameter along the lines (stride 1) */
+   std::vector<float>  m_tabFloat;      /**< the table in float, STORE_FLOAT */
+   std::vector<TabBandLine> m_bandLines; /**< banded storage: the band of each line */
+   std::vector<double> m_bandValues;    /**< band values, STORE_BAND */
+   std::vector<float>  m_bandFloat;     /**< band values, STORE_BAND_FLOAT */
    bool                m_tabulated;   /**< true if tabulate() is called successfully */
 
    std::string         m_name;        /**< name */
@@ -113,6 +260,20 @@ protected:
    std::vector<bool>   m_parChanged;  /**< flags which parameters were changed since last vector in tabulate()        */
    std::vector<size_t> m_parIndex;    /**< indecis obtained by calcTabIndex() */
 
+   INTERP              m_interp;      /**< interpolation policy */
+   unsigned int        m_taylorAxes;  /**< axes using INTERP_TAYLOR */
+
+   double              m_growth;         /**< relative growth per extension, 0 => no extension */
+   size_t              m_growMaxSize;    /**< max number of nodes after extension */
+   size_t              m_growCredit;     /**< out-of-range calls (above max) since tabulate() or the last extension */
+   bool                m_warnedFallback; /**< true once the out-of-range warning is printed */
+
+   unsigned long       m_statNtabulate; /**< number of tabulate() calls */
+   unsigned long       m_statNlookup;   /**< number of table lookups */
+   unsigned long       m_statNfallback; /**< number of out-of-range calls to calcValue() */
+   unsigned long       m_statNdirect;   /**< number of calls to calcValue() before tabulation */
+   unsigned long       m_statNextend;   /**< number of table extensions */
+
 };
 
 #endif
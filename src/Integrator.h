@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <cmath>
 #include <stdlib.h>
 #include <gsl/gsl_math.h>
@@ -27,9 +28,17 @@
 
     void myFun( double *x, size_t dim, void *params );
 
+  Integrators that evaluate the points in blocks (IntegratorQMC, IntegratorCubature) also accept a batch version,
+  see setBatchFunction(); the others ignore it.
+
  */
 class Integrator {
 public:
+   //! integrator types, see Pole::setIntType()
+   enum TYPE { INT_VEGAS=0, INT_QMC, INT_CUBATURE };
+   //! batch function: fval[i] = f(&x[i*dim]) for i=0..npts-1
+   typedef void (* BatchFunction)(double * x, size_t npts, size_t dim, void * params, double * fval);
+
    //! main constructor
    inline Integrator();
    //! destructor
@@ -39,6 +48,8 @@ public:
    //@{
    //! set function to be integrated
    inline void setFunction( double (* f)(double * x, size_t dim, void * params) );
+   //! set batch version of the function (0 => none) - optional
+   inline void setBatchFunction( BatchFunction fb );
    //! set function dimension
    inline void setFunctionDim( size_t dim );
    //! set function parameters
@@ -62,6 +73,8 @@ public:
    inline double result() const;
    //! get error
    inline double error() const;
+   //! number of calls to go() since construction
+   inline unsigned long getNIntegrations() const { return m_nIntegrations; }
    //@}
    //! accessors
    inline double getIntXmin( size_t pind ) const;
@@ -71,17 +84,24 @@ protected:
    gsl_rng            *m_gslRange;    /**< GSL range */
    unsigned int        m_ncalls;      /**< number of iterations */
    gsl_monte_function  m_gslMonteFun; /**< structure for GSL MC integration */
+   BatchFunction       m_batchFun;    /**< batch version of m_gslMonteFun.f, 0 if none */
    std::vector<double> m_intXL;       /**< lower integration range for each integrand */
    std::vector<double> m_intXU;       /**< idem, upper */
 
    double m_result;           /**< result of integration */
    double m_error;            /**< error of idem */
+   unsigned long m_nIntegrations; /**< number of integrations performed */
 };
 
 /*! @class IntegratorVegas
 
 @brief Implements the 'Vegas' algorithm
 
+By default, each go() starts from a uniform grid and spends part of the calls adapting it.
+With setWarmStart(), go() continues on the grid adapted by the previous go() - when
+tabulating, this is the neighbouring cell - and uses fewer calls. If the grid does not fit the
+integrand, seen by chi2/dof above a maximum, the integral is redone on a new grid.
+
 */
 class IntegratorVegas : public Integrator {
 public:
@@ -90,8 +110,133 @@ public:
    inline virtual void go();
    inline virtual void initialize();
    inline virtual double chisq();
+   /*! @name Warm start */
+   //@{
+   //! use nc calls on the grid of the previous go() (0 => new grid each time); redo if chi2/dof > chisqMax
+   inline void setWarmStart( unsigned int nc, double chisqMax=2.0 );
+   //! next go() starts on a new grid
+   inline void resetWarmStart() { m_gridReady = false; }
+   inline unsigned int  getWarmCalls()     const { return m_warmCalls; }
+   inline double        getWarmChisqMax()  const { return m_warmChisqMax; }
+   //! number of go() on a warm grid
+   inline unsigned long getNWarm()         const { return m_nWarm; }
+   //! number of go() on a warm grid that were redone on a new grid
+   inline unsigned long getNReadapt()      const { return m_nReadapt; }
+   //@}
 private:
+   inline void integrate( unsigned int nc, int stage );
+
    gsl_monte_vegas_state *m_gslVegasState; /**< GSL vegas state */
+   unsigned int        m_warmCalls;    /**< number of calls on a warm grid, 0 => no warm start */
+   double              m_warmChisqMax; /**< maximum chi2/dof accepted on a warm grid */
+   bool                m_gridReady;    /**< true if the state holds a grid adapted by go() */
+   std::vector<double> m_gridXL;       /**< m_intXL when the grid was made */
+   std::vector<double> m_gridXU;       /**< idem, m_intXU */
+   unsigned long       m_nWarm;        /**< number of go() on a warm grid */
+   unsigned long       m_nReadapt;     /**< idem, redone on a new grid */
+};
+
+/*! @class IntegratorQMC
+
+@brief Randomized quasi-Monte Carlo with scrambled Sobol points
+
+The calls are split over setNShifts() randomizations of the Sobol sequence, each using the
+largest power of 2 that fits. A randomization is a random linear scrambling of the direction
+numbers and a random digital shift. The result is the mean over the randomizations, and the
+error is its standard error. For smooth integrands, the error falls close to 1/N(calls)
+instead of 1/sqrt(N(calls)).
+
+The randomizations are drawn in initialize() and reused by each go(). The errors of
+neighbouring table cells are then correlated, and the table stays smooth in s.
+Points are evaluated in blocks, with the batch function if one is set.
+At most s_maxDim dimensions.
+
+*/
+class IntegratorQMC : public Integrator {
+public:
+   inline IntegratorQMC();
+   inline virtual ~IntegratorQMC();
+   inline virtual void go();
+   inline virtual void initialize();
+   //! no chi2 - returns 0
+   inline virtual double chisq();
+   //! set number of randomizations (>=2), default 8 - takes effect at initialize()
+   inline void setNShifts( unsigned int n ) { m_nShifts = (n<2 ? 2:n); }
+   inline unsigned int getNShifts() const { return m_nShifts; }
+
+   static const size_t s_maxDim   = 8;   /**< maximum dimension - direction numbers of Joe and Kuo */
+   static const size_t s_nBits    = 32;  /**< bits per coordinate */
+   static const size_t s_blockSize = 64; /**< points per function block */
+private:
+   inline unsigned int randomBits();
+
+   unsigned int              m_nShifts; /**< number of randomizations */
+   std::vector<unsigned int> m_dirNum;  /**< scrambled direction numbers [shift][dim][bit] */
+   std::vector<unsigned int> m_shift;   /**< digital shift [shift][dim] */
+   std::vector<double>       m_points;  /**< block of points [point][dim] */
+   std::vector<double>       m_values;  /**< function values of the block */
+};
+
+/*! @class IntegratorCubature
+
+@brief Deterministic adaptive cubature
+
+The region with the largest error estimate is halved along the axis where the integrand
+varies most, until the total error is below max(absTol, relTol*|result|) or the number of
+function calls reaches setNcalls(). The regions are kept in a heap ordered by error.
+If the call budget ends the loop first, the tolerance is not reached; such go() are counted,
+see getNBudgetStops().
+
+Each region uses the degree 7 rule of Genz and Malik, with the embedded degree 5 rule for the
+error and the fourth differences for the split axis. In 1 dimension, the 15 point
+Gauss-Kronrod rule and its embedded 7 point Gauss rule are used instead.
+The error is the difference of the two rules - an estimate, not a strict bound.
+
+There is no random state, so the result depends only on the integrand and the settings.
+The points of the two halves of a split are evaluated in one block, with the batch function
+if one is set.
+
+*/
+class IntegratorCubature : public Integrator {
+public:
+   inline IntegratorCubature();
+   inline virtual ~IntegratorCubature();
+   inline virtual void go();
+   inline virtual void initialize();
+   //! no chi2 - returns 0
+   inline virtual double chisq();
+   //! stop when the error is below max(absTol, relTol*|result|)
+   inline void setTolerance( double relTol, double absTol=0.0 ) { m_relTol = relTol; m_absTol = absTol; }
+   inline double getRelTolerance() const { return m_relTol; }
+   inline double getAbsTolerance() const { return m_absTol; }
+   //! number of regions at the end of the last go()
+   inline size_t getNRegions() const { return m_regions.size(); }
+   //! true if the call budget ended the last go() before the tolerance was reached
+   inline bool getBudgetStop() const { return m_budgetStop; }
+   //! number of go() ended by the call budget before the tolerance
+   inline unsigned long getNBudgetStops() const { return m_nBudgetStops; }
+
+   struct Region {
+      size_t index;  /**< first coordinate in m_geometry: center[dim], then half width[dim] */
+      double value;  /**< integral over the region */
+      double error;  /**< error estimate */
+      size_t split;  /**< axis for the next split */
+      bool operator<( const Region & other ) const { return error < other.error; }
+   };
+private:
+   inline size_t rulePoints() const;
+   inline void   makePoints( const Region & r, double *x ) const;
+   inline void   applyRule( Region & r, const double *f ) const;
+   inline void   evalRegions( Region *r, size_t nr );
+
+   double              m_relTol;    /**< relative tolerance */
+   double              m_absTol;    /**< absolute tolerance */
+   bool                m_budgetStop;   /**< last go() ended by the call budget */
+   unsigned long       m_nBudgetStops; /**< number of such go() */
+   std::vector<Region> m_regions;   /**< heap of regions, largest error first */
+   std::vector<double> m_geometry;  /**< center and half widths of the regions */
+   std::vector<double> m_points;    /**< points of a block [point][dim] */
+   std::vector<double> m_values;    /**< function values of the block */
 };
 
 /*! @class IntegratorPlain
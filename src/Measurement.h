@@ -52,6 +52,8 @@ namespace MEAS {
     inline void setObsVal(T val);
     inline void setName(const char *name);
     inline void setDescription(const char *descr);
+    //! set the random generator used by the observable and all nuisance parameters
+    inline void setRndGen(const RND::Random *rndgen);
     //
     inline OBS::Base *addNuisance(OBS::Base * nuPar);
     inline void deleteNuisance();
@@ -80,6 +82,7 @@ namespace MEAS {
     inline const std::string & getDescription()               const;
     inline const std::list< OBS::Base * > & getNuisanceList() const;
     inline const double getNuisanceIntNorm()                  const;
+    inline const RND::Random *getRndGen()                     const;
 
     inline const double rndObs();
     //
@@ -115,6 +118,7 @@ namespace MEAS {
     std::vector< std::vector<int> >         m_nuisanceIndecis; //! indecis of (x,y...) -> (i,j,....) used in vector above
     std::vector< int >                      m_nuisanceIndMax;  //! maximum index per parameter
     double				  m_nuisanceIntNorm;
+    const RND::Random                      *m_rndGen;          //! random generator given to all observables
   };
 
   class MeasPois : public Measurement<int> {
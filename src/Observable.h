@@ -187,6 +187,18 @@ namespace OBS {
     inline ObservableLogN *clone() const;
   };
 
+  class ObservableGamma : public BaseType<double> {
+  public:
+    inline ObservableGamma();
+    inline ObservableGamma(const char *name, const char *desc=0);
+    inline ObservableGamma(const ObservableGamma & other);
+    inline virtual ~ObservableGamma();
+    //
+    inline ObservableGamma const & operator=(ObservableGamma const & rh);
+    inline double rnd() const;
+    inline ObservableGamma *clone() const;
+  };
+
   class ObservablePois : public BaseType<int> {
   public:
     inline ObservablePois();
@@ -1,16 +1,59 @@
 #define PDF_CXX
+#include <pthread.h>
 #include "Pdf.h"
 
 namespace PDF {
+  //
+  // per-thread shape caches - a key per type deletes the cache of a thread when it exits
+  //
+  namespace {
+    pthread_mutex_t s_shapeGenLock = PTHREAD_MUTEX_INITIALIZER;
+    unsigned long   s_shapeGen     = 0;
+    pthread_key_t   s_logNormalKey;
+    pthread_key_t   s_gammaKey;
+    void deleteLogNormalCache(void *cache) { delete static_cast<ShapeCache<LogNormalShape> *>(cache); }
+    void deleteGammaCache(void *cache)     { delete static_cast<ShapeCache<GammaShape> *>(cache); }
+    struct ShapeCacheInit {
+      ShapeCacheInit() {
+        pthread_key_create(&s_logNormalKey,deleteLogNormalCache);
+        pthread_key_create(&s_gammaKey,deleteGammaCache);
+      }
+    };
+    ShapeCacheInit s_shapeCacheInit;
+  };
+
+  unsigned long newShapeGen() {
+    pthread_mutex_lock(&s_shapeGenLock);
+    const unsigned long gen = ++s_shapeGen;
+    pthread_mutex_unlock(&s_shapeGenLock);
+    return gen;
+  }
+
+  ShapeCache<LogNormalShape> *newLogNormalCache() {
+    ShapeCache<LogNormalShape> *cache = new ShapeCache<LogNormalShape>;
+    pthread_setspecific(s_logNormalKey,cache);
+    return cache;
+  }
+
+  ShapeCache<GammaShape> *newGammaCache() {
+    ShapeCache<GammaShape> *cache = new ShapeCache<GammaShape>;
+    pthread_setspecific(s_gammaKey,cache);
+    return cache;
+  }
+
+  LogFactorial gLogFactorial(LOGFACNMAX);
+
   Poisson  gPoisson;
   Poisson  gPoissonTab;
   //  PoisTab  gPoisTab(&gPoissonTab);
   Gauss    gGauss;
   GaussTab gGaussTab(&gGauss);
+  LogNormalTab gLogNormalTab(&gGaussTab);
+  Gamma    gGamma;
+  GammaTab gGammaTab;
 
   Gauss2D   gGauss2D;
   LogNormal gLogNormal;
   Flat      gFlat;
   ConstVal  gConstVal;
 };
-
@@ -4,12 +4,12 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include "Random.h"
 #include "Tools.h"
 #include "Tabulator.h"
-
-#define USE_STAT
-//#undef  USE_STAT
+#include "FastMath.h"
+#include "Profile.h"
 /*!
   
  */
@@ -31,6 +31,10 @@ namespace PDF {
 #else
   extern bool gPrintStat;
 #endif
+  //
+  // Usage statistics and profile - see Profile.h
+  //
+  using PROF::Stat;
   enum DISTYPE {
     DIST_CONST=0,  /*!< No distrubution - const value */
     DIST_POIS,     /*!< Poisson */
@@ -81,6 +85,34 @@ namespace PDF {
     }
     return rval;
   }
+  /*! @class LogFactorial
+
+    @brief Table of ln(n!) for n=0..nmax, filled at startup
+
+    Outside the table, lgamma(n+1) is used.
+    setNmax() refills the table - must not be called while pdfs are used in threads.
+  */
+  class LogFactorial {
+  public:
+    LogFactorial(const int nmax) { setNmax(nmax); }
+    ~LogFactorial() {}
+    //
+    void setNmax(const int nmax) {
+      m_nmax = (nmax<1 ? 1:nmax);
+      m_table.resize(m_nmax+1);
+      for (int n=0; n<=m_nmax; n++) m_table[n] = lgamma(static_cast<double>(n)+1.0);
+    }
+    inline const int    getNmax() const { return m_nmax; }
+    inline const double operator()(const int n) const {
+      return (((n>=0) && (n<=m_nmax)) ? m_table[n] : lgamma(static_cast<double>(n)+1.0));
+    }
+  private:
+    int                 m_nmax;
+    std::vector<double> m_table;
+  };
+  //! default size of gLogFactorial - covers N(obs) for means up to ~1000
+  const int LOGFACNMAX = 2048;
+  extern LogFactorial gLogFactorial;
   //
   // Help functions for Log Normal dist
   //
@@ -89,20 +121,36 @@ namespace PDF {
   //
   class Base {
   public:
-    Base() { m_dist=DIST_UNDEF; m_statNraw = 0; m_statNrawCache=0; m_statNtot=0; m_statNtab=0; m_iTabulator=0;}
+    Base() { m_dist=DIST_UNDEF; m_iTabulator=0; m_statSlot=PROF::newStatSlot(&m_name); }
     Base(const char *name, DISTYPE d=DIST_UNDEF, double m=0.0, double s=0.0)
-      :m_dist(d), m_mean(m), m_sigma(s), m_statNraw(0), m_statNrawCache(0),m_statNtot(0), m_statNtab(0)
-    { if (name) m_name=name; setDist(d); m_iTabulator=0; }
-    Base(const Base & other) { copy(other); m_statNraw=0; m_statNrawCache=0; m_statNtot=0; m_statNtab=0; m_iTabulator=0; }
-    virtual ~Base() { this->printStat(); if (m_iTabulator) delete m_iTabulator;}
+      :m_dist(d), m_mean(m), m_sigma(s)
+    { if (name) m_name=name; setDist(d); m_iTabulator=0; m_statSlot=PROF::newStatSlot(&m_name); }
+    Base(const Base & other) { copy(other); m_iTabulator=0; m_statSlot=PROF::newStatSlot(&m_name); }
+    virtual ~Base() {
+      if (gPrintStat) this->printStat();
+      if (m_iTabulator) delete m_iTabulator;
+      PROF::releaseStatSlot(m_statSlot);
+    }
     //
-    virtual void clrStat() const {  m_statNraw = 0; m_statNrawCache=0; m_statNtot=0; m_statNtab=0; }
+    //! clear the usage counters of the calling thread
+    virtual void clrStat() const { getThreadStat().clear(); }
+    //! usage counters summed over all threads
+    void getStat(Stat & stat) const { PROF::sumStat(m_statSlot,stat); }
+    //! usage counters of the calling thread
+    Stat & getThreadStat() const { return PROF::threadStat(m_statSlot); }
+    //! profile slot, see PROF::Probe
+    int getStatSlot() const { return m_statSlot; }
+    //! add n to the given counter if profiling is on, e.g. count(&Stat::ntab)
+    inline void count(unsigned long Stat::*counter, unsigned long n=1) const {
+      if (PROF::gEnabled) getThreadStat().*counter += n;
+    }
     virtual void setMean(double m)  { m_mean  = m; }
     virtual void setSigma(double s) { m_sigma = s; }
     //
     virtual void initTabulator() { m_iTabulator = 0; }
     virtual void tabulate()    { if (!m_iTabulator) return; if (!m_iTabulator->isTabulated()) m_iTabulator->tabulate(); }
     virtual bool isTabulated() const { return (m_iTabulator ? m_iTabulator->isTabulated():false); }
+    const ITabulator *getTabulator() const { return m_iTabulator; }
 
     virtual const double getVal(const double x, const double mean, const double sigma) const {
       std::cerr << "ERROR: PDF::Base - Accessing getVal(x,m,s) - VERBOTEN!!!" << std::endl;
@@ -124,20 +172,30 @@ namespace PDF {
       exit(-1);
       return 0;
     }
+    //! log of getVal(x,m,s) - overloaded where it can be done without exp()
+    virtual const double getLogVal(const double x, const double mean, const double sigma) const {
+      return std::log(this->getVal(x,mean,sigma));
+    }
+    //! log of getVal(x,m)
+    virtual const double getLogVal(const int x, const double mean) const {
+      return std::log(this->getVal(x,mean));
+    }
     const std::string & getName() const { return m_name;}
     const DISTYPE getDist()      const { return m_dist;}
     const double  getMean()      const { return m_mean;}
     const double  getSigma()     const { return m_sigma;}
 
     virtual void printStat() const {
-      if (gPrintStat) {
-        std::cout << "----- " << this->getName() << " -----" << std::endl;
-        std::cout << " PDF called                    : " << this->m_statNtot << std::endl;
-        std::cout << " PDF called using raw function : " << this->m_statNraw << std::endl;
-        std::cout << " PDF called using raw cache    : " << this->m_statNrawCache << std::endl;
-        std::cout << " PDF called using table        : " << this->m_statNtab << std::endl;
-        std::cout << "--------------------------------------------------" << std::endl;
-      }
+      Stat stat;
+      getStat(stat);
+      std::cout << "----- " << this->getName() << " -----" << std::endl;
+      std::cout << " PDF called                    : " << stat.ntot << std::endl;
+      std::cout << " PDF called using raw function : " << stat.nraw << std::endl;
+      std::cout << " PDF called using raw cache    : " << stat.nrawCache << std::endl;
+      std::cout << " PDF called using table        : " << stat.ntab << std::endl;
+      std::cout << " PDF called outside table      : " << stat.nfallback << std::endl;
+      std::cout << " cycles per call (sampled)     : " << stat.cyclesPerCall() << std::endl;
+      std::cout << "--------------------------------------------------" << std::endl;
     }
 
     virtual const bool isInt()    const { return false; }
@@ -161,10 +219,7 @@ namespace PDF {
     double      m_sigma;
 
     mutable ITabulator *m_iTabulator;
-    mutable int m_statNraw;
-    mutable int m_statNrawCache;
-    mutable int m_statNtot;
-    mutable int m_statNtab;
+    int         m_statSlot; // slot of the usage counters
   };
 
   template <typename T>
@@ -183,6 +238,10 @@ namespace PDF {
     virtual const double cdf(T x) const=0;
     const double getVal(const T x, const double mean, const double sigma) const {std::cerr << "ERROR: Accessing getVal(T x,m,s) - NOT IMPLEMENTED for this class" << std::endl; exit(-1); return 0;}
     const double getVal(const T x, const double mean) const {std::cerr << "ERROR: Accessing getVal(T x,m) - NOT IMPLEMENTED for this class" << std::endl; exit(-1); return 0;}
+    //! batch version of getVal(x,mean,sigma): out[i] = f(x[i]|mean,sigma), i=0..n-1
+    virtual void getVals(const T *x, const double mean, const double sigma, double *out, const size_t n) const {
+      for (size_t i=0; i<n; i++) out[i] = this->getVal(x[i],mean,sigma);
+    }
     inline const double operator()(T x) const { return pdf(x); }
 
      const bool isInt()    const { return false; }
@@ -273,6 +332,8 @@ namespace PDF {
     inline const double cdf(double val) const { return 0; }
     inline const double phi(double mu) const;
     inline const double getVal(const double x, const double mean, const double sigma) const;
+    inline const double getLogVal(const double x, const double mean, const double sigma) const;
+    inline void getVals(const double *x, const double mean, const double sigma, double *out, const size_t n) const;
   };
 
   class Gauss2D : public Gauss {
@@ -309,19 +370,23 @@ namespace PDF {
     inline const double pdf(const double x) const {return (x>0.0 ? Gauss::getVal(std::log(x),m_logMean,m_logSigma)/x:0.0);}
     inline const double cdf(const double x) const { return 0; }
     inline const double getVal(const double x, const double m, const double s) const {
-#ifdef USE_STAT
-      m_statNtot++;
-#endif
+      PROF::Probe probe(this->getStatSlot());
       if (x<=0) return 0.0;
-#ifdef USE_STAT
-      m_statNraw++;
-#endif
+      probe.count(&Stat::nraw);
       return Gauss::getVal(std::log(x),calcLogMean(m,s), calcLogSigma(m,s))/x;
     }
+    inline const double getLogVal(const double x, const double m, const double s) const {
+      if (x<=0) return -HUGE_VAL;
+      const double lx = std::log(x);
+      return Gauss::getLogVal(lx,calcLogMean(m,s), calcLogSigma(m,s)) - lx;
+    }
+    //! the batch version in Gauss does not apply
+    void getVals(const double *x, const double mean, const double sigma, double *out, const size_t n) const {
+      BaseType<double>::getVals(x,mean,sigma,out,n);
+    }
     inline const double getValLogN(const double x, const double m, const double s) const {
-#ifdef USE_STAT
-      m_statNraw++;
-#endif
+      PROF::Probe probe(this->getStatSlot());
+      probe.count(&Stat::nraw);
       return Gauss::getVal(x, m, s)/std::exp(x);
     }
   protected:
@@ -342,9 +407,11 @@ namespace PDF {
     inline const double pdf(const double val) const;
     inline const double cdf(const double x) const { return 0; }
     inline const double getVal(const double x, const double mean, const double sigma) const;
+    inline const double getLogVal(const double x, const double mean, const double sigma) const;
   protected:
     inline void updParams();
     inline const double raw(const double x, const double k, const double theta) const;
+    inline const double logRaw(const double x, const double k, const double theta) const;
 
     double m_theta;
     double m_k;
@@ -352,9 +419,9 @@ namespace PDF {
 
   class Poisson : public BaseType<int> {
   public:
-    Poisson():BaseType<int>("Poisson",DIST_POIS,1.0,1.0) {}
-    Poisson(const double lambda):BaseType<int>("Poisson",DIST_POIS,lambda,std::sqrt(lambda)) {}
-    Poisson(const Poisson & other):BaseType<int>(other) {}
+    Poisson():BaseType<int>("Poisson",DIST_POIS,1.0,1.0) { m_poisTabulator=0; clrTabView(); }
+    Poisson(const double lambda):BaseType<int>("Poisson",DIST_POIS,lambda,std::sqrt(lambda)) { m_poisTabulator=0; clrTabView(); }
+    Poisson(const Poisson & other):BaseType<int>(other) { m_poisTabulator=0; clrTabView(); }
 
     virtual ~Poisson() {}
     //
@@ -369,7 +436,14 @@ namespace PDF {
       m_poisTabulator->setVerbose(false);
       m_poisTabulator->setFunction( this );
       m_poisTabulator->setTabNPar(2); // two parameters to be tabulated (N, mean)
-      m_tabVec.resize(2); // vector used by rawOrTab()
+    }
+    //! tabulate - must be done before using the pdf in threads
+    void tabulate() { Base::tabulate(); setTabView(); }
+    //! interpolation in the table - INTERP_DEFAULT is the Taylor expansion in the mean, see poisTaylor()
+    void setTabInterpolation( ITabulator::INTERP interp ) {
+      if (m_poisTabulator==0) return;
+      m_poisTabulator->setInterpolation(interp);
+      setTabView();
     }
     void setTabN( int nmin, int nmax ) {
       if (m_poisTabulator==0) return;
@@ -399,18 +473,84 @@ namespace PDF {
     inline const double getVal(const int x, const double mean) const;
     virtual inline const double getVal(const double x, const double mean, const double sigma) const;
     inline const double getVal(const double x, const double mean) const;
+    //! batch: out[i] = Po(x[i]|mean), i=0..n-1
+    inline void getVals(const int *x, const double mean, const double sigma, double *out, const size_t n) const;
+    //! batch: out[i] = Po(x|mean[i]), i=0..n-1 ; mean and out must not overlap
+    inline void getValsMean(const int x, const double *mean, double *out, const size_t n) const;
+    //! column: out[i] = Po(nmin+i|mean), i=0..n-1 ; one exp() at the mode, then recursion both ways
+    inline void getColumn(const double mean, const int nmin, double *out, const int n) const;
+    //! idem, ln Po(nmin+i|mean) - no exp() at all
+    inline void getLogColumn(const double mean, const int nmin, double *out, const int n) const;
+    //! ln Po(x|mean) - never uses the table
+    inline const double getLogVal(const int x, const double mean) const;
+    inline const double getLogVal(const double x, const double mean, const double sigma) const;
     inline const double raw(const int n, const double s) const;
-    inline const double rawCacheNP1() const;
+    inline const double logRaw(const int n, const double s) const;
     inline const double rawOrTab(const int n, const double s) const;
   protected:
+    inline void clrTabView();
+    inline void setTabView();
     Tabulator<Poisson> *m_poisTabulator;
-    // temp storage/cache
-    mutable std::vector<double> m_tabVec;
-    mutable int    m_cacheN;
-    mutable double m_cacheMean;
-    mutable double m_cacheValue;
-    
+    // read-only view of the table, set by tabulate() - used by rawOrTab()
+    const double *m_tabData;
+    double m_tabSmin;
+    double m_tabSstep;
+    int    m_tabNs;
+    int    m_tabNmin;
+    int    m_tabNn;
+    bool   m_tabGeneric; // use Tabulator::getTabValue()
+  };
+
+  /*! @class PoissonCursor
+
+    @brief Iterates Po(n|s) over n using Po(n+1|s) = Po(n|s)*s/(n+1)
+
+    The recurrence state is owned by the caller, hence the pdf is not modified.
+   */
+  class PoissonCursor {
+  public:
+    PoissonCursor(const Poisson & pdf):m_pdf(pdf),m_n(0),m_mean(0.0),m_value(0.0) {}
+    ~PoissonCursor() {}
+    //! start at Po(n|s)
+    inline const double start(const int n, const double s) {
+      m_n     = n;
+      m_mean  = s;
+      m_value = m_pdf.raw(n,s);
+      return m_value;
+    }
+    //! step to Po(n+1|s)
+    inline const double next() {
+      if (PROF::gEnabled) {
+        Stat & stat = m_pdf.getThreadStat();
+        stat.ntot++;
+        stat.nrawCache++;
+      }
+      m_n++;
+      m_value *= m_mean/static_cast<double>(m_n);
+      return m_value;
+    }
+    inline const int    getN()     const { return m_n; }
+    inline const double getMean()  const { return m_mean; }
+    inline const double getValue() const { return m_value; }
+  private:
+    const Poisson & m_pdf;
+    int    m_n;
+    double m_mean;
+    double m_value;
   };
+
+  //! Po(x|lmb0+dlmb) from f0 = Po(x|lmb0), Taylor expansion to second order
+  inline const double poisTaylor(const double f0, const double lmb0, const double x, const double dlmb) {
+    double alpha=0.0;
+    double beta=0.0;
+    if (lmb0>0.0) {
+      alpha = (x/lmb0)-1.0;
+      beta  = x/(lmb0*lmb0);
+    }
+    double corr1 = f0*alpha*dlmb;
+    double corr2 = 0.5*f0*(alpha*alpha - beta)*dlmb*dlmb;
+    return f0 + corr1 + corr2;
+  }
    
   template <typename T>
   class Tabulated : public BaseType<T> {
@@ -519,6 +659,7 @@ namespace PDF {
     }
 
     virtual const double getVal(T x, double m, double s) const {
+      PROF::Probe probe(this->getStatSlot());
       if ((m_table!=0) &&
 	  (x>=m_xmin) && (x<=m_xmax) &&
 	  (m>=m_mmin) && (m<=m_mmax) &&
@@ -529,9 +670,7 @@ namespace PDF {
 	xind = int(m_dx>0 ? (x-m_xmin)/m_dx : 0);
 	ind = xind + mind*m_nX + sind*m_nX*m_nMean;
 	if (ind<m_nTotal) {
-#ifdef USE_STAT
-          this->m_statNtab++;
-#endif
+          probe.count(&Stat::ntab);
 	  return m_table[ind];
         }
       }
@@ -634,9 +773,7 @@ namespace PDF {
     void setSigma(double sigma) { this->m_pdf->setSigma(sigma); this->m_sigma = sigma; this->m_mean  = this->m_pdf->getMean(); }
 
     virtual const double getVal(int x, double m) const {
-#ifdef USE_STAT
-      this->m_statNtot++;
-#endif
+      PROF::Probe probe(this->getStatSlot());
       //
       // check if table is created and that the requested values are within the table
       // if not, the value will be calculated using raw()
@@ -669,9 +806,7 @@ namespace PDF {
           }
           double corr1 = f0*alpha*dlmb;
           double corr2 = 0.5*f0*(alpha*alpha - beta)*dlmb*dlmb;
-#ifdef USE_STAT
-          this->m_statNtab++;
-#endif
+          probe.count(&Stat::ntab);
 	  return f0 + corr1 + corr2;
         }
         // This line should never be called - a BUG trap
@@ -687,9 +822,7 @@ namespace PDF {
       //
       // Call the raw() function
       //
-#ifdef USE_STAT
-      this->m_statNraw++;
-#endif
+      probe.count(&Stat::nraw);
       return this->m_pdf->getVal(x,m,0); // Poisson ignores sigma
     }
     //
@@ -702,45 +835,124 @@ namespace PDF {
 
   };
     
+  /*! @class GaussTab
+
+    @brief Tabulated standard normal phi(mu), mu = |x-mean|/sigma, with interpolation
+
+    The table covers 0 <= mu <= muMax; outside, phi() is evaluated directly.
+    The step is chosen from the requested maximum error relative to phi(mu), using
+    phi^(k)(mu) = He_k(mu)*phi(mu) for the error terms:
+    - linear  : err = h^2/8 * max|mu^2-1|
+    - Hermite : err = h^4/384 * max|mu^4-6mu^2+3|, using phi'(mu) = -mu*phi(mu)
+    The error term is at a point within h of mu, where phi is larger by up to exp(muMax*h);
+    the step is reduced by this factor, so the bound also holds in the tail.
+    Hermite is the default and needs a few hundred points for 1e-6.
+    The table is read-only after tabulate(), hence getVal() is thread safe.
+    setMaxRelError(), setMuMax() and setInterpolation() retabulate and
+    must not be called while the pdf is used in threads.
+  */
   class GaussTab : public Tabulated<double> {
   public:
-    GaussTab():Tabulated<double>() {}
+    enum INTERP {
+      INTERP_NONE=0, /*!< nearest lower node */
+      INTERP_LINEAR, /*!< linear */
+      INTERP_HERMITE /*!< cubic Hermite */
+    };
+    GaussTab():Tabulated<double>() { initDefault(); }
     GaussTab(Gauss *pdf):Tabulated<double>() {
+      this->m_name = "Tabulated Gaussian";
       this->m_pdf = pdf;
       this->m_dist = DIST_GAUS;
       this->m_mean  = pdf->getMean();
       this->m_sigma = pdf->getSigma();
+      initDefault();
+      tabulate();
     }
     virtual ~GaussTab() {}
     //
-    void tabulateOld() {
-      if (this->m_pdf==0) return;
-      m_nSigma = 1; // force them to be unity - tabulate only for N(0,1)
+    //! maximum relative error - if <=0, no table is used
+    void setMaxRelError(double err) { m_maxRelErr = err; tabulate(); }
+    //! upper limit of the table in units of sigma
+    void setMuMax(double mumax)     { m_muMax = (mumax>0.0 ? mumax:1.0); tabulate(); }
+    void setInterpolation(INTERP interp) { m_interp = interp; tabulate(); }
+    //
+    const double getMaxRelError()  const { return m_maxRelErr; }
+    const double getMuMax()        const { return m_muMax; }
+    const INTERP getInterpolation() const { return m_interp; }
+    virtual bool isTabulated()     const { return (m_table!=0); }
+    //
+    //! fill the table - nodes i=0..nX-1 at mu = i*dx, stored as pairs (phi, phi')
+    void tabulate() {
+      clearTable();
+      if ((this->m_pdf==0) || (!(m_maxRelErr>0.0))) return;
+      const double mu2 = m_muMax*m_muMax;
+      double h;
+      double order;
+      switch (m_interp) {
+      case INTERP_HERMITE:
+        h = std::pow(384.0*m_maxRelErr/std::max(3.0,fabs(mu2*mu2-6.0*mu2+3.0)),0.25);
+        order = 4.0;
+        break;
+      case INTERP_LINEAR:
+        h = std::sqrt(8.0*m_maxRelErr/std::max(1.0,fabs(mu2-1.0)));
+        order = 2.0;
+        break;
+      default:
+        // nearest node: err = h*max|phi'/phi| = h*muMax
+        h = m_maxRelErr/std::max(1.0,m_muMax);
+        order = 1.0;
+        break;
+      }
+      // relative to phi(mu): err ~ h^order*exp(muMax*h), see above
+      h *= std::exp(-m_muMax*h/order);
+      // limit the size - relevant without interpolation
+      const int nmax = 1048576;
+      if (m_muMax/h > static_cast<double>(nmax)) {
+        std::cout << "WARNING: GaussTab - table limited to " << nmax << " points, requested rel. error "
+                  << m_maxRelErr << " is not reached" << std::endl;
+        h = m_muMax/static_cast<double>(nmax);
+      }
+      m_xmin   = 0.0;
+      m_nX     = static_cast<int>(std::ceil(m_muMax/h)) + 1;
+      m_dx     = m_muMax/static_cast<double>(m_nX-1);
+      m_xmax   = m_muMax;
       m_nMean  = 1;
-      initTab();
-      if (m_table==0) return;
-      double x;
-      for (int n=0; n<m_nX; n++) {
-	x = double(n)*m_dx+m_xmin;
-	m_table[n] = static_cast<Gauss *>(this->m_pdf)->phi(x);
+      m_nSigma = 1;
+      m_nTotal = 2*m_nX;
+      m_table  = new double[m_nTotal];
+      const Gauss *gauss = static_cast<const Gauss *>(this->m_pdf);
+      for (int i=0; i<m_nX; i++) {
+        const double mu = static_cast<double>(i)*m_dx;
+        m_table[2*i]   = gauss->phi(mu);
+        m_table[2*i+1] = -mu*m_table[2*i];
+      }
+    }
+    //! phi(mu) from the table, 0 <= mu < muMax
+    inline const double interpolate(const double mu) const {
+      const double u  = mu/m_dx;
+      int    i        = static_cast<int>(u);
+      if (i>m_nX-2) i = m_nX-2;
+      const double *f = &m_table[2*i];
+      const double t  = u - static_cast<double>(i);
+      switch (m_interp) {
+      case INTERP_HERMITE: {
+        const double t1 = 1.0-t;
+        return ( t1*t1*((1.0+2.0*t)*f[0] + t*m_dx*f[1]) +
+                 t*t*((3.0-2.0*t)*f[2] - t1*m_dx*f[3]) );
+      }
+      case INTERP_LINEAR:
+        return f[0] + t*(f[2]-f[0]);
+      default:
+        return f[0];
       }
     }
 
-    virtual const double getVal(double x, double m, double s) const {
-#ifdef USE_STAT
-      m_statNtot++;
-#endif
-      if (m_table!=0) {
-	double mu = fabs((x-m)/s);
-	if (mu>m_xmax)
-	  return static_cast<Gauss *>(this->m_pdf)->phi(mu)/s;
-	int muind = int(m_dx>0 ? (mu-m_xmin)/m_dx : 0);
-	if (muind<m_nTotal) {
-#ifdef USE_STAT
-          this->m_statNtab++;
-#endif
-	  return m_table[muind];
-        }
+    //! phi(mu), mu >= 0 - from the table if possible
+    inline const double phi(const double mu) const {
+      PROF::Probe probe(this->getStatSlot());
+      if ((m_table!=0) && (mu<m_xmax)) {
+        probe.count(&Stat::ntab);
+        return interpolate(mu);
       }
       //
       if (this->m_pdf==0) {
@@ -748,13 +960,236 @@ namespace PDF {
         exit(-1);
         return 0;
       }
-#ifdef USE_STAT
-      m_statNraw++;
-#endif
-      return this->m_pdf->getVal(x,m,s);
+      probe.count(&Stat::nraw);
+      return static_cast<const Gauss *>(this->m_pdf)->phi(mu);
+    }
+
+    virtual const double getVal(double x, double m, double s) const {
+      return phi(fabs((x-m)/s))/s;
     }
+    //! exact - the log does not need a table
+    virtual const double getLogVal(const double x, const double m, const double s) const {
+      return static_cast<const Gauss *>(this->m_pdf)->getLogVal(x,m,s);
+    }
+  private:
+    void initDefault() {
+      m_interp    = INTERP_HERMITE;
+      m_maxRelErr = 1e-6;
+      m_muMax     = 8.0;
+      m_nX = 0; m_nMean = 0; m_nSigma = 0; m_nTotal = 0;
+    }
+    INTERP m_interp;    /**< interpolation method */
+    double m_maxRelErr; /**< requested maximum relative error */
+    double m_muMax;     /**< table range in sigma */
   };
   
+  /*! @class ShapeCache
+
+    @brief The derived parameters of the last few (mean,sigma) used by a pdf
+
+    One cache exists per thread, see LogNormalTab::getShape() - hence no locking is needed.
+    The entries are keyed by (owner,generation,mean,sigma) and replaced round robin.
+    An owner whose settings enter the shape takes a new generation from newShapeGen() when
+    it is made and when a setting changes. Hence neither a changed setting nor a new pdf at
+    the address of a deleted one finds a stale entry.
+    S must provide set(owner,mean,sigma).
+  */
+  const int NSHAPECACHE = 4;
+  template <typename S>
+  class ShapeCache {
+  public:
+    ShapeCache():m_next(0),m_n(0) {}
+    ~ShapeCache() {}
+    inline const S & get(const void *owner, const unsigned long gen, const double mean, const double sigma) {
+      for (int i=0; i<m_n; i++) {
+        if ((m_owner[i]==owner) && (m_gen[i]==gen) && (m_mean[i]==mean) && (m_sigma[i]==sigma)) return m_shape[i];
+      }
+      const int i = m_next;
+      m_owner[i] = owner;
+      m_gen[i]   = gen;
+      m_mean[i]  = mean;
+      m_sigma[i] = sigma;
+      m_shape[i].set(owner,mean,sigma);
+      m_next = (m_next+1)%NSHAPECACHE;
+      if (m_n<NSHAPECACHE) m_n++;
+      return m_shape[i];
+    }
+  private:
+    S             m_shape[NSHAPECACHE];
+    const void   *m_owner[NSHAPECACHE];
+    unsigned long m_gen[NSHAPECACHE];
+    double        m_mean[NSHAPECACHE];
+    double        m_sigma[NSHAPECACHE];
+    int           m_next;
+    int           m_n;
+  };
+  //! a generation number not used before, see ShapeCache
+  unsigned long newShapeGen();
+
+  //! derived parameters of LogNormal(mean,sigma)
+  struct LogNormalShape {
+    void set(const void *, const double mean, const double sigma) {
+      logMean     = calcLogMean(mean,sigma);
+      logSigma    = calcLogSigma(mean,sigma);
+      invLogSigma = 1.0/logSigma;
+    }
+    double logMean;
+    double logSigma;
+    double invLogSigma;
+  };
+  //! cache for the calling thread - deleted when the thread exits
+  ShapeCache<LogNormalShape> *newLogNormalCache();
+
+  /*! @class LogNormalTab
+
+    @brief LogNormal using cached log-mean/sigma and the interpolated phi() of a GaussTab
+
+    Per point, only log(x) is evaluated.
+  */
+  class LogNormalTab : public LogNormal {
+  public:
+    LogNormalTab(const GaussTab *gtab):LogNormal(),m_gaussTab(gtab) { this->m_name="Tabulated LogNormal"; }
+    LogNormalTab(const LogNormalTab & other):LogNormal(other),m_gaussTab(other.m_gaussTab) {}
+    virtual ~LogNormalTab() {}
+    //
+    inline const LogNormalShape & getShape(const double m, const double s) const {
+      static __thread ShapeCache<LogNormalShape> *cache = 0;
+      if (cache==0) cache = newLogNormalCache();
+      return cache->get(this,0,m,s); // depends on (m,s) only - no generation
+    }
+    inline const double getVal(const double x, const double m, const double s) const {
+      PROF::Probe probe(this->getStatSlot());
+      if (x<=0) return 0.0;
+      const LogNormalShape & shape = getShape(m,s);
+      const double mu = fabs(std::log(x)-shape.logMean)*shape.invLogSigma;
+      return m_gaussTab->phi(mu)*shape.invLogSigma/x;
+    }
+    inline const GaussTab *getGaussTab() const { return m_gaussTab; }
+    inline const double getLogVal(const double x, const double m, const double s) const {
+      if (x<=0) return -HUGE_VAL;
+      const LogNormalShape & shape = getShape(m,s);
+      const double lx = std::log(x);
+      const double mu = (lx-shape.logMean)*shape.invLogSigma;
+      return -0.5*mu*mu - std::log(std::sqrt(2.0*M_PIl)*shape.logSigma) - lx;
+    }
+  private:
+    const GaussTab *m_gaussTab;
+  };
+
+  class GammaTab;
+  /*! @struct GammaShape
+
+    @brief Derived parameters of Gamma(mean,sigma) and a table of the standardized pdf
+
+    With y = x/theta, g(y) = y^(k-1) exp(-y)/Gamma(k) and f(x) = g(y)/theta.
+    For k >= 2, g and g' are tabulated around the mode y0 = k-1 in steps of
+    h*sqrt(k), where h is the GaussTab Hermite step for the requested error.
+  */
+  struct GammaShape {
+    inline void set(const void *owner, const double mean, const double sigma);
+    inline const double logG(const double y) const { return (k-1.0)*std::log(y) - y + lnorm; }
+    double k;
+    double theta;
+    double invTheta;
+    double lnorm;   // -ln(Gamma(k))
+    double ymin;    // table range in y
+    double ymax;
+    double dy;
+    int    ny;
+    std::vector<double> table; // pairs (g,g')
+  };
+  //! cache for the calling thread - deleted when the thread exits
+  ShapeCache<GammaShape> *newGammaCache();
+
+  /*! @class GammaTab
+
+    @brief Gamma using cached parameters and an interpolated per-shape table
+
+    Outside the table (and for k < 2) one log and one exp are used per point,
+    lgamma() only once per shape.
+  */
+  class GammaTab : public Gamma {
+  public:
+    GammaTab():Gamma(),m_maxRelErr(1e-6),m_nSigma(8.0),m_shapeGen(newShapeGen()) { this->m_name="Tabulated Gamma"; }
+    GammaTab(const GammaTab & other):Gamma(other),m_maxRelErr(other.m_maxRelErr),m_nSigma(other.m_nSigma),m_shapeGen(newShapeGen()) {}
+    virtual ~GammaTab() {}
+    //
+    //! maximum relative error - if <=0, no table is used ; must not be changed while used in threads
+    void setMaxRelError(double err) { m_maxRelErr = err; m_shapeGen = newShapeGen(); }
+    //! table range around the mode, in units of sqrt(k)
+    void setNSigma(double ns)       { m_nSigma = (ns>0.0 ? ns:1.0); m_shapeGen = newShapeGen(); }
+    const double getMaxRelError() const { return m_maxRelErr; }
+    const double getNSigma()      const { return m_nSigma; }
+    //
+    inline const GammaShape & getShape(const double m, const double s) const {
+      static __thread ShapeCache<GammaShape> *cache = 0;
+      if (cache==0) cache = newGammaCache();
+      return cache->get(this,m_shapeGen,m,s);
+    }
+    inline const double getVal(const double x, const double m, const double s) const {
+      PROF::Probe probe(this->getStatSlot());
+      if (!(x>0.0)) return 0.0;
+      const GammaShape & shape = getShape(m,s);
+      const double y = x*shape.invTheta;
+      if ((y>=shape.ymin) && (y<shape.ymax)) {
+        probe.count(&Stat::ntab);
+        const double u  = (y-shape.ymin)/shape.dy;
+        int    i        = static_cast<int>(u);
+        if (i>shape.ny-2) i = shape.ny-2;
+        const double *g = &shape.table[2*i];
+        const double t  = u - static_cast<double>(i);
+        const double t1 = 1.0-t;
+        return ( t1*t1*((1.0+2.0*t)*g[0] + t*shape.dy*g[1]) +
+                 t*t*((3.0-2.0*t)*g[2] - t1*shape.dy*g[3]) )*shape.invTheta;
+      }
+      probe.count(&Stat::nraw);
+      return std::exp(shape.logG(y))*shape.invTheta;
+    }
+    inline const double getLogVal(const double x, const double m, const double s) const {
+      if (!(x>0.0)) return -HUGE_VAL;
+      const GammaShape & shape = getShape(m,s);
+      return shape.logG(x*shape.invTheta) - std::log(shape.theta);
+    }
+  private:
+    double m_maxRelErr; /**< requested max relative error of the table */
+    double m_nSigma;    /**< table range */
+    unsigned long m_shapeGen; /**< generation of the settings, see ShapeCache */
+  };
+
+  inline void GammaShape::set(const void *owner, const double mean, const double sigma) {
+    const GammaTab *pdf = static_cast<const GammaTab *>(owner);
+    theta    = sigma*sigma/mean;
+    invTheta = 1.0/theta;
+    k        = mean/theta;
+    lnorm    = -lgamma(k);
+    ny       = 0;
+    ymin     = 0.0;
+    ymax     = 0.0;
+    dy       = 0.0;
+    table.clear();
+    const double err = pdf->getMaxRelError();
+    if ((!(err>0.0)) || (!(k>=2.0))) return; // no table
+    const double ns  = pdf->getNSigma();
+    const double sk  = std::sqrt(k);
+    const double y0  = k-1.0;
+    ymin = std::max(y0 - ns*sk, 0.5*y0); // g ~ y^(k-1) close to 0 is not well interpolated
+    ymax = y0 + ns*sk;
+    // step as for GaussTab with Hermite, in units of the width sqrt(k) - with the slope
+    // q = |d ln(g)/dz| at the table ends replacing mu, since the tails are not symmetric
+    const double q   = std::max(ns, sk*std::max(fabs(y0/ymin - 1.0), fabs(y0/ymax - 1.0)));
+    const double q2  = q*q;
+    const double h   = std::pow(384.0*err/std::max(3.0,fabs(q2*q2-6.0*q2+3.0)),0.25)*sk;
+    ny   = static_cast<int>(std::ceil((ymax-ymin)/h)) + 1;
+    dy   = (ymax-ymin)/static_cast<double>(ny-1);
+    table.resize(2*ny);
+    for (int i=0; i<ny; i++) {
+      const double y = ymin + static_cast<double>(i)*dy;
+      const double g = std::exp(logG(y));
+      table[2*i]   = g;
+      table[2*i+1] = g*((k-1.0)/y - 1.0);
+    }
+  }
+
   // class General : public Base<double> {
   // public:
   //   General():Base<double>("General") {}
@@ -783,13 +1218,31 @@ namespace PDF {
     return this->getVal(x,this->m_mean,this->m_sigma);
   }
   inline const double Gauss::getVal(const double x, const double mean, const double sigma) const {
-#ifdef USE_STAT
-    m_statNraw++;
-#endif
+    PROF::Probe probe(this->getStatSlot());
+    probe.count(&Stat::nraw);
     double mu = fabs((x-mean)/sigma); // symmetric around mu0
     return phi(mu)/sigma;
   }
 
+  inline const double Gauss::getLogVal(const double x, const double mean, const double sigma) const {
+    PROF::Probe probe(this->getStatSlot());
+    probe.count(&Stat::nraw);
+    const double mu = (x-mean)/sigma;
+    return -0.5*mu*mu - std::log(std::sqrt(2.0*M_PIl)*sigma);
+  }
+
+  inline void Gauss::getVals(const double *x, const double mean, const double sigma, double *out, const size_t n) const {
+    PROF::Probe probe(this->getStatSlot(),n);
+    probe.count(&Stat::nraw,n);
+    const double norm = 1.0/(std::sqrt(2.0*M_PIl)*sigma);
+    for (size_t i=0; i<n; i++) {
+      const double mu = (x[i]-mean)/sigma;
+      out[i] = -0.5*mu*mu;
+    }
+    FMATH::vexp(out,out,n);
+    for (size_t i=0; i<n; i++) out[i] *= norm;
+  }
+
   inline const double Gauss2D::getVal2D(double x1, double mu1, double s1, double x2, double mu2, double s2, double corr) const {
     double sdetC = std::sqrt(getDetC(s1,s2,corr));
     double seff1 = sdetC/s2;
@@ -829,11 +1282,21 @@ namespace PDF {
     double k = mean/t;
     return raw(x,k,t);
   }
+  inline const double Gamma::getLogVal(const double x, const double mean, const double sigma) const {
+    double t = sigma*sigma/mean;
+    double k = mean/t;
+    return logRaw(x,k,t);
+  }
+  inline const double Gamma::logRaw(const double x, const double k, const double theta) const {
+    PROF::Probe probe(this->getStatSlot());
+    probe.count(&Stat::nraw);
+    const double xt   = x/theta;
+    double lnf = (k-1.0)*std::log(xt) - xt - std::log(theta) - lgamma(k);
+    return (std::isnan(lnf) ? -HUGE_VAL : lnf);
+  }
   inline const double Gamma::raw(const double x, const double k, const double theta) const {
-#ifdef USE_STAT
-    m_statNtot++;
-    m_statNraw++;
-#endif
+    PROF::Probe probe(this->getStatSlot());
+    probe.count(&Stat::nraw);
     const double xt   = x/theta;
     double lnf = (k-1.0)*std::log(xt) - xt - std::log(theta) - lgamma(k);
     double prob;
@@ -861,25 +1324,102 @@ namespace PDF {
     return rawOrTab(int(x+0.5),mean);
   }
 
-  inline const double Poisson::rawCacheNP1() const {
-    // will calculate Po(n+1|s) assuming that raw(0,s) has been called followed by rawCachedNP1() until n
-#ifdef USE_STAT
-    m_statNtot++;
-    m_statNrawCache++;
-#endif
-    m_cacheN++;
-    m_cacheValue *= m_cacheMean/static_cast<double>(m_cacheN);
-    return m_cacheValue;
+  inline void Poisson::getVals(const int *x, const double mean, const double sigma, double *out, const size_t n) const {
+    if (m_tabData || (!(mean>0.0))) {
+      BaseType<int>::getVals(x,mean,sigma,out,n);
+      return;
+    }
+    PROF::Probe probe(this->getStatSlot(),n);
+    probe.count(&Stat::nraw,n);
+    // same as raw(): exp(n*ln(s) - ln(n!) - s)
+    const double lns = std::log(mean);
+    for (size_t i=0; i<n; i++) {
+      out[i] = static_cast<double>(x[i])*lns - gLogFactorial(x[i]) - mean;
+    }
+    FMATH::vexp(out,out,n);
+  }
+
+  inline void Poisson::getValsMean(const int x, const double *mean, double *out, const size_t n) const {
+    if (m_tabData) {
+      for (size_t i=0; i<n; i++) out[i] = rawOrTab(x,mean[i]);
+      return;
+    }
+    PROF::Probe probe(this->getStatSlot(),n);
+    probe.count(&Stat::nraw,n);
+    // same as raw(): exp(n*ln(s) - ln(n!) - s)
+    const double xd  = static_cast<double>(x);
+    const double lnn = gLogFactorial(x);
+    FMATH::vlog(mean,out,n);
+    for (size_t i=0; i<n; i++) {
+      out[i] = xd*out[i] - lnn - mean[i];
+    }
+    FMATH::vexp(out,out,n);
+    // s<=0 : as in raw()
+    for (size_t i=0; i<n; i++) {
+      if (!(mean[i]>0.0)) out[i] = (x==0 ? 1.0:0.0);
+    }
+  }
+
+  inline const double Poisson::getLogVal(const int x, const double mean) const {
+    return logRaw(x,mean);
+  }
+  inline const double Poisson::getLogVal(const double x, const double mean, const double sigma) const {
+    return logRaw(int(x+0.5),mean);
+  }
+
+  inline const double Poisson::logRaw(const int n, const double s) const {
+    PROF::Probe probe(this->getStatSlot());
+    probe.count(&Stat::nraw);
+    double lnf = double(n)*std::log(s) - gLogFactorial(n) - s;
+    if (std::isinf(lnf) || std::isnan(lnf)) {
+      lnf = (n==0 ? 0.0 : -HUGE_VAL); // as raw()
+    }
+    return lnf;
+  }
+
+  inline void Poisson::getColumn(const double mean, const int nmin, double *out, const int n) const {
+    if (n<1) return;
+    if (!(mean>0.0)) {
+      for (int i=0; i<n; i++) out[i] = (nmin+i==0 ? 1.0:0.0); // as raw()
+      return;
+    }
+    // start at the mode, or the n closest to it - this is the largest value in the column
+    int i0 = static_cast<int>(mean) - nmin;
+    if (i0<0)  i0 = 0;
+    if (i0>=n) i0 = n-1;
+    out[i0] = raw(nmin+i0,mean);
+    PROF::Probe probe(this->getStatSlot(),n-1);
+    probe.count(&Stat::nrawCache,n-1);
+    // Po(k+1) = Po(k)*mean/(k+1) ; values below the mode underflow gracefully to 0
+    for (int i=i0+1; i<n; i++) {
+      out[i] = out[i-1]*mean/static_cast<double>(nmin+i);
+    }
+    for (int i=i0-1; i>=0; i--) {
+      out[i] = out[i+1]*static_cast<double>(nmin+i+1)/mean;
+    }
+  }
+
+  inline void Poisson::getLogColumn(const double mean, const int nmin, double *out, const int n) const {
+    if (n<1) return;
+    if (!(mean>0.0)) {
+      for (int i=0; i<n; i++) out[i] = (nmin+i==0 ? 0.0:-HUGE_VAL);
+      return;
+    }
+    PROF::Probe probe(this->getStatSlot(),n);
+    probe.count(&Stat::nraw,n);
+    const double lns = std::log(mean);
+    for (int i=0; i<n; i++) {
+      const int k = nmin+i;
+      out[i] = static_cast<double>(k)*lns - gLogFactorial(k) - mean;
+    }
   }
 
   inline const double Poisson::raw(const int n, const double s) const {
-#ifdef USE_STAT
-    m_statNtot++;
-    m_statNraw++;
-#endif
+    PROF::Probe probe(this->getStatSlot());
+    probe.count(&Stat::nraw);
     double prob = 0.0;
     double nlnl = double(n)*std::log(s);  // n*ln(s)
-    double lnn  = lgamma(n+1);       // ln(fac(n))
+    double lnn  = gLogFactorial(n);  // ln(fac(n))
     double lnf  = nlnl - lnn - s;
     if (std::isinf(lnf) || std::isnan(lnf)) {
       prob=(n==0 ? 1.0:0.0);
@@ -889,16 +1429,13 @@ namespace PDF {
     if (std::isnan(prob)) {
       std::cout << "NaN in rawPoisson: " << n << ", " << s << ", " << prob << std::endl;
     }
-    m_cacheN     = n;
-    m_cacheMean  = s;
-    m_cacheValue = prob;
     return prob;
   }
 
 //   inline const double Poisson::rawOrTab(const int n, const double s) const {
 //     if (isTabulated()) {
 // #ifdef USE_STAT
-//       m_statNtab++;
+//       this->getThreadStat().ntab++;
 // #endif
 //       m_tabVec[0] = s;
 //       m_tabVec[1] = static_cast<double>(n);
@@ -936,16 +1473,14 @@ namespace PDF {
   }
 
   inline const double Flat::raw(const double x, const double f) const {
-#ifdef USE_STAT
-    m_statNraw++;
-#endif
+    PROF::Probe probe(this->getStatSlot());
+    probe.count(&Stat::nraw);
     return (((x>=m_min) && (x<=m_max)) ? f:0);
   }
 
   inline const double Flat::raw(const double x, const double f, const double xmin, const double xmax) const {
-#ifdef USE_STAT
-    m_statNraw++;
-#endif
+    PROF::Probe probe(this->getStatSlot());
+    probe.count(&Stat::nraw);
     return (((x>=xmin) && (x<=xmax)) ? f:0);
   }
 //   template <typename T>
@@ -979,6 +1514,9 @@ namespace PDF {
   //   extern PoisTab  gPoisTab;
   extern Gauss    gGauss;
   extern GaussTab gGaussTab;
+  extern LogNormalTab gLogNormalTab;
+  extern Gamma    gGamma;
+  extern GammaTab gGammaTab;
    
   extern Gauss2D   gGauss2D;
   extern LogNormal gLogNormal;
@@ -993,70 +1531,24 @@ inline double Tabulator<PDF::Poisson>::calcValue() {
   // m_parameters contains:
   // [1] = N
   // [0] = s
-  if (m_parChanged[1] && (!m_parChanged[0])) {
-    return m_function->rawCacheNP1();
-  } else {
-    return m_function->raw( static_cast<int>(m_parameters[1]+0.5), m_parameters[0] );
-  }
-  return 0;
+  return m_function->raw( static_cast<int>(m_parameters[1]+0.5), m_parameters[0] );
 }
 
 template<>
 inline double Tabulator<PDF::Poisson>::interpolate( size_t ind ) const {
-   //  std::cout << "USING Pois interp" << std::endl;
-   //  std::cout << "f(N|s) =  " << this->m_tabValues[ind] << " :  N = " << m_parameters[1] << " , s = " << m_parameters[0] << std::endl;
   // m_parameters contains:
   // [1] = N
   // [0] = s
   //
-  //   return this->m_tabValues[ind];
-
   size_t mind = m_parIndex[0];
   double lmb0 = double(mind)*m_tabStep[0] + m_tabMin[0]; // discretized mean
-  double x = m_parameters[1];
-  double dlmb = m_parameters[0] - lmb0;                   // diff relative requested mean
-  double f0   = this->m_tabValues[ind];                  // f() at discretized mean
-  //  std::cout << "interp: " << lmb0 << " , "
-  //            << x << std::endl;
-  //
-  // Do Taylor expansion around lmb0 to second order
-  //
-  double alpha=0.0;
-  double beta=0.0;
-  if (lmb0>0.0) {
-    alpha = (double(x)/lmb0)-1.0;
-    beta  = double(x)/(lmb0*lmb0);
-  }
-  double corr1 = f0*alpha*dlmb;
-  double corr2 = 0.5*f0*(alpha*alpha - beta)*dlmb*dlmb;
-  //  std::cout << "interp corr: " << corr1 << " , " << corr2 << std::endl;
-  return f0 + corr1 + corr2;
+  return PDF::poisTaylor(this->m_tabValues[ind], lmb0, m_parameters[1], m_parameters[0] - lmb0);
 }
 
 template<>
 inline double Tabulator<PDF::Poisson>::getValue( double n, double s ) {
-   // [1] = N
-   // [0] = s
-   int ni = static_cast<int>(n);
-   m_parameters[0] = s;
-   m_parameters[1] = n;
-   m_parChanged[0] = true;
-   m_parChanged[1] = true;
-   const double smin    = m_tabMin[0];
-   //   const double smax    = m_tabMax[0];
-   const double sstep   = m_tabStep[0];
-   const int nsignal    = m_tabNsteps[0];
-   const int    nmin    = static_cast<int>(m_tabMin[1]);
-   const int    nmax    = static_cast<int>(m_tabMax[1]);
-   const int    nn      = nmax-nmin+1;
-   //
-   int indN = ni - nmin;
-   int indS = static_cast<int>(0.5+((s - smin)/sstep));
-   if ((indN<0) || (indN>=nn) || (indS<0) || (indS>=nsignal)) return calcValue();
-   int ind = indS*nn+indN;
-   m_parIndex[0] = indS;
-   m_parIndex[1] = indN;
-   return interpolate(ind);
+   // the lookup is done by the pdf - it does not modify the tabulator
+   return m_function->rawOrTab(static_cast<int>(n), s);
 }
 
 template<>
@@ -1073,46 +1565,56 @@ inline void Tabulator<PDF::Poisson>::tabulate() {
    const int    nmax    = static_cast<int>(m_tabMax[1]);
    const int    nn      = nmax-nmin+1;
    //
-   std::vector<double> pars(2);
+   // one column P(nmin..nmax | mean) per mean, see Poisson::getColumn()
    for (size_t m=0; m<nsignal; m++) {
-      double mean = m*sstep+smin;
-      // start at n0 = int(mean) -> important if mean is very large
-      int n0 = static_cast<int>(mean);
-      if (n0<nmin) n0=nmin;
-      if (n0>nmax) n0=nmax;
-      int indn0 = n0-nmin;
-      int ind0 = m*nn;
-      pars[0] = mean;
-      pars[1] = static_cast<double>(n0);
-//       if (m<10) {
-//          std::cout << "mean = " << mean << " : " << smin << " : " << smax << " : " << sstep << std::endl;
-//          std::cout << "N    = " << n0   << " : " << nmin << " : " << nmax << " : " << nn    << std::endl;
-//       }
-//      int indtst = calcTabIndex( pars );
-      //    std::cout << "indtst, ind0 = " << indtst << " : " << ind0+indn0 << std::endl;
-      // set reference point at maximum
-      m_tabValues[ind0+indn0] = m_function->raw(n0,mean);
-      // set for all n>n0
-      for (int n=indn0+1; n<nn; n++) {
-         m_tabValues[ind0+n] = m_tabValues[ind0+n-1]*mean/static_cast<double>(n+nmin);
-      }
-      // set for all n<n0
-      for (int n=indn0-1; n>=0; n--) {
-         m_tabValues[ind0+n] = m_tabValues[ind0+n+1]*static_cast<double>(n+nmin+1)/mean;
-      }
+      const double mean = m*sstep+smin;
+      m_function->getColumn(mean, nmin, &m_tabValues[m*nn], nn);
    }
    m_tabulated = true;
+   m_statNtabulate++;
+}
+
+inline void PDF::Poisson::clrTabView() {
+   m_tabData  = 0;
+   m_tabSmin  = 0;
+   m_tabSstep = 1.0;
+   m_tabNs    = 0;
+   m_tabNmin  = 0;
+   m_tabNn    = 0;
+   m_tabGeneric = false;
+}
+
+inline void PDF::Poisson::setTabView() {
+   clrTabView();
+   if ((m_poisTabulator==0) || (!m_poisTabulator->isTabulated())) return;
+   if (m_poisTabulator->getTabValues().empty()) return;
+   // [1] = N
+   // [0] = s
+   m_tabSmin  = m_poisTabulator->getTabMin(0);
+   m_tabSstep = m_poisTabulator->getTabStep(0);
+   m_tabNs    = static_cast<int>(m_poisTabulator->getTabNsteps(0));
+   m_tabNmin  = static_cast<int>(m_poisTabulator->getTabMin(1));
+   m_tabNn    = static_cast<int>(m_poisTabulator->getTabMax(1)) - m_tabNmin + 1;
+   m_tabData  = &(m_poisTabulator->getTabValues()[0]);
+   m_tabGeneric = (m_poisTabulator->getInterpolation()!=ITabulator::INTERP_DEFAULT);
 }
 
 inline const double PDF::Poisson::rawOrTab(const int n, const double s) const {
-   if (isTabulated()) {
-#ifdef USE_STAT
-      m_statNtab++;
-#endif
-//       m_tabVec[0] = s;
-//       m_tabVec[1] = static_cast<double>(n);
-//       return m_poisTabulator->getValue( m_tabVec );
-      return m_poisTabulator->getValue(static_cast<double>(n), s);
+   if (m_tabData) {
+      const int indN = n - m_tabNmin;
+      const int indS = static_cast<int>(0.5+((s - m_tabSmin)/m_tabSstep));
+      if ((indN>=0) && (indN<m_tabNn) && (indS>=0) && (indS<m_tabNs)) {
+         PROF::Probe probe(this->getStatSlot());
+         probe.count(&Stat::ntab);
+         if (m_tabGeneric) {
+            const double x[2] = { s, static_cast<double>(n) }; // [0] = s, [1] = N
+            double val;
+            if (m_poisTabulator->getTabValue(x,val)) return val;
+         }
+         const double lmb0 = double(indS)*m_tabSstep + m_tabSmin; // discretized mean
+         return poisTaylor(m_tabData[indS*m_tabNn+indN], lmb0, static_cast<double>(n), s-lmb0);
+      }
+      this->count(&Stat::nfallback);
    }
    return raw(n,s);
 }
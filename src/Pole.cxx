@@ -15,8 +15,15 @@
 
 namespace LIMITS {
 
+  namespace {
+    // profile slot of the integrand, see PROF::Probe
+    const std::string s_poleFunName("poleFun");
+    const int         s_poleFunSlot = PROF::newStatSlot(&s_poleFunName);
+  };
+
   double poleFun(double *k, size_t dim, void *params)
   {
+    PROF::Probe probe(s_poleFunSlot);
     // k[0] = eff
     // k[1] = bkg
     // params = &PoleData
@@ -37,10 +44,211 @@ namespace LIMITS {
     return fn*fe*fb;
   }
 
+  void poleFunBatch(double *k, size_t npts, size_t dim, void *params, double *f)
+  {
+    for (size_t i=0; i<npts; i++) f[i] = poleFun(&k[i*dim],dim,params);
+  }
+
+  //
+  // poleFun() specialized at compile time for the (eff,bkg) pdf pair.
+  // A nuisance policy provides
+  //   init()   : loop invariant terms of the pdf -> par[3], called once per setup
+  //   value()  : the integration variable, or the observed value if constant
+  //   weight() : the pdf at x - inlined, without virtual calls
+  //
+  namespace {
+    struct NuisConst {
+      static void init(const PDF::Base *pdf, double obs, double sigma, double *par) {
+        par[0] = (pdf ? pdf->getVal(obs,obs,sigma) : 1.0);
+      }
+      static inline double value(const double *, int, double obs) { return obs; }
+      static inline double weight(const PDF::Base *, double, double, double, const double *par) { return par[0]; }
+    };
+
+    struct NuisVar {
+      static inline double value(const double *k, int index, double) { return k[index]; }
+    };
+
+    // PDF::GaussTab - par = 1/sigma
+    struct NuisGauss : public NuisVar {
+      static void init(const PDF::Base *, double, double sigma, double *par) {
+        par[0] = 1.0/sigma;
+      }
+      static inline double weight(const PDF::Base *pdf, double x, double obs, double, const double *par) {
+        return static_cast<const PDF::GaussTab *>(pdf)->phi(fabs(x-obs)*par[0])*par[0];
+      }
+    };
+
+    // PDF::LogNormalTab - par = log-mean, 1/log-sigma
+    struct NuisLogN : public NuisVar {
+      static void init(const PDF::Base *, double obs, double sigma, double *par) {
+        par[0] = PDF::calcLogMean(obs,sigma);
+        par[1] = 1.0/PDF::calcLogSigma(obs,sigma);
+      }
+      static inline double weight(const PDF::Base *pdf, double x, double, double, const double *par) {
+        if (x<=0) return 0.0;
+        PROF::Probe probe(pdf->getStatSlot());
+        const PDF::GaussTab *gtab = static_cast<const PDF::LogNormalTab *>(pdf)->getGaussTab();
+        return gtab->phi(fabs(std::log(x)-par[0])*par[1])*par[1]/x;
+      }
+    };
+
+    // PDF::GammaTab - its shape cache holds the invariants
+    struct NuisGamma : public NuisVar {
+      static void init(const PDF::Base *, double, double, double *) {}
+      static inline double weight(const PDF::Base *pdf, double x, double obs, double sigma, const double *) {
+        return static_cast<const PDF::GammaTab *>(pdf)->PDF::GammaTab::getVal(x,obs,sigma);
+      }
+    };
+
+    // PDF::Flat - par = range and value
+    struct NuisFlat : public NuisVar {
+      static void init(const PDF::Base *, double obs, double sigma, double *par) {
+        TOOLS::calcFlatRange(obs,sigma,par[0],par[1]);
+        const double d = par[1]-par[0];
+        par[2] = (d>0 ? 1.0/d:-1); // as Flat::calcVal()
+      }
+      static inline double weight(const PDF::Base *, double x, double, double, const double *par) {
+        return (((x>=par[0]) && (x<=par[1])) ? par[2]:0);
+      }
+    };
+
+    // anything else - virtual call
+    struct NuisPdf : public NuisVar {
+      static void init(const PDF::Base *, double, double, double *) {}
+      static inline double weight(const PDF::Base *pdf, double x, double obs, double sigma, const double *) {
+        return pdf->getVal(x,obs,sigma);
+      }
+    };
+
+    template <class E, class B>
+    inline double poleValT(const double *k, const PoleData *pd) {
+      const double effval = E::value(k, pd->effIndex, pd->effObs);
+      const double bkgval = B::value(k, pd->bkgIndex, pd->bkgObs);
+      const double fe = E::weight(pd->pdfEff, effval, pd->effObs, pd->deffObs, pd->effPar);
+      const double fb = B::weight(pd->pdfBkg, bkgval, pd->bkgObs, pd->dbkgObs, pd->bkgPar);
+      const double fn = static_cast<const PDF::Poisson *>(pd->pdfObs)->PDF::Poisson::getVal(pd->nobs, effval*pd->signal + bkgval);
+      return fn*fe*fb;
+    }
+
+    template <class E, class B>
+    double poleFunT(double *k, size_t, void *params) {
+      PROF::Probe probe(s_poleFunSlot);
+      return poleValT<E,B>(k, static_cast<const PoleData *>(params));
+    }
+
+    // batch version - one probe per block
+    // The nuisance weights and the Poisson means are collected per block of
+    // at most POLEBATCH points, and the Poisson is evaluated by one Poisson::getValsMean().
+    const size_t POLEBATCH = 64;
+
+    template <class E, class B>
+    void poleFunBatchT(double *k, size_t npts, size_t dim, void *params, double *f) {
+      PROF::Probe probe(s_poleFunSlot,npts);
+      const PoleData *pd = static_cast<const PoleData *>(params);
+      const PDF::Poisson *pois = static_cast<const PDF::Poisson *>(pd->pdfObs);
+      double lambda[POLEBATCH];
+      double weight[POLEBATCH];
+      for (size_t i0=0; i0<npts; i0+=POLEBATCH) {
+        const size_t nb = std::min(POLEBATCH,npts-i0);
+        for (size_t i=0; i<nb; i++) {
+          const double *ki = &k[(i0+i)*dim];
+          const double effval = E::value(ki, pd->effIndex, pd->effObs);
+          const double bkgval = B::value(ki, pd->bkgIndex, pd->bkgObs);
+          weight[i] = E::weight(pd->pdfEff, effval, pd->effObs, pd->deffObs, pd->effPar)*
+                      B::weight(pd->pdfBkg, bkgval, pd->bkgObs, pd->dbkgObs, pd->bkgPar);
+          lambda[i] = effval*pd->signal + bkgval;
+        }
+        pois->PDF::Poisson::getValsMean(pd->nobs, lambda, &f[i0], nb);
+        for (size_t i=0; i<nb; i++) f[i0+i] *= weight[i];
+      }
+    }
+
+    struct PoleFuns {
+      PoleFunPtr      fun;
+      PoleFunBatchPtr batch;
+    };
+
+    template <class E, class B>
+    PoleFuns poleFuns() {
+      PoleFuns f;
+      f.fun   = &poleFunT<E,B>;
+      f.batch = &poleFunBatchT<E,B>;
+      return f;
+    }
+
+    enum NUISKIND { NUIS_CONST, NUIS_GAUSS, NUIS_LOGN, NUIS_GAMMA, NUIS_FLAT, NUIS_PDF };
+
+    NUISKIND getNuisKind(const PDF::Base *pdf, int index) {
+      if ((index<0) || (pdf==0))                    return NUIS_CONST;
+      if (dynamic_cast<const PDF::GaussTab *>(pdf))     return NUIS_GAUSS;
+      if (dynamic_cast<const PDF::LogNormalTab *>(pdf)) return NUIS_LOGN;
+      if (dynamic_cast<const PDF::GammaTab *>(pdf))     return NUIS_GAMMA;
+      if (dynamic_cast<const PDF::Flat *>(pdf))         return NUIS_FLAT;
+      return NUIS_PDF;
+    }
+
+    void initNuis(NUISKIND kind, const PDF::Base *pdf, double obs, double sigma, double *par) {
+      par[0] = par[1] = par[2] = 0.0;
+      switch (kind) {
+      case NUIS_CONST: NuisConst::init(pdf,obs,sigma,par); break;
+      case NUIS_GAUSS: NuisGauss::init(pdf,obs,sigma,par); break;
+      case NUIS_LOGN:  NuisLogN::init(pdf,obs,sigma,par);  break;
+      case NUIS_GAMMA: NuisGamma::init(pdf,obs,sigma,par); break;
+      case NUIS_FLAT:  NuisFlat::init(pdf,obs,sigma,par);  break;
+      default:         NuisPdf::init(pdf,obs,sigma,par);   break;
+      }
+    }
+
+    template <class E>
+    PoleFuns selectBkg(NUISKIND kind) {
+      switch (kind) {
+      case NUIS_CONST: return poleFuns<E,NuisConst>();
+      case NUIS_GAUSS: return poleFuns<E,NuisGauss>();
+      case NUIS_LOGN:  return poleFuns<E,NuisLogN>();
+      case NUIS_GAMMA: return poleFuns<E,NuisGamma>();
+      case NUIS_FLAT:  return poleFuns<E,NuisFlat>();
+      default:         return poleFuns<E,NuisPdf>();
+      }
+    }
+
+    PoleFuns selectPoleFuns( PoleData & pd ) {
+      if (dynamic_cast<const PDF::Poisson *>(pd.pdfObs)==0) {
+        PoleFuns f;
+        f.fun   = &poleFun;
+        f.batch = &poleFunBatch;
+        return f;
+      }
+      const NUISKIND ke = getNuisKind(pd.pdfEff, pd.effIndex);
+      const NUISKIND kb = getNuisKind(pd.pdfBkg, pd.bkgIndex);
+      initNuis(ke, pd.pdfEff, pd.effObs, pd.deffObs, pd.effPar);
+      initNuis(kb, pd.pdfBkg, pd.bkgObs, pd.dbkgObs, pd.bkgPar);
+      switch (ke) {
+      case NUIS_CONST: return selectBkg<NuisConst>(kb);
+      case NUIS_GAUSS: return selectBkg<NuisGauss>(kb);
+      case NUIS_LOGN:  return selectBkg<NuisLogN>(kb);
+      case NUIS_GAMMA: return selectBkg<NuisGamma>(kb);
+      case NUIS_FLAT:  return selectBkg<NuisFlat>(kb);
+      default:         return selectBkg<NuisPdf>(kb);
+      }
+    }
+  };
+
+  PoleFunPtr selectPoleFun( PoleData & pd ) {
+    return selectPoleFuns(pd).fun;
+  }
+
+  PoleFunBatchPtr selectPoleFunBatch( PoleData & pd ) {
+    return selectPoleFuns(pd).batch;
+  }
+
   Pole::Pole() { initDefault(); }
 
   void Pole::initDefault() {
     m_calcProbBuf.resize(2);
+    m_poleIntFixedHits  = 0;
+    m_poleIntTabExtends = 0;
+    setTabGrowth(0.0);
     m_cl             = 0.90;
     m_thresholdBS    = 0.001;
     m_thresholdPrec  = 0.01;
@@ -58,7 +266,10 @@ namespace LIMITS {
     m_upperLimitPrec = -1.0;
 
 
+    m_intType      = Integrator::INT_VEGAS;
     m_gslIntNCalls = 10000;
+    m_gslIntWarmCalls = 0;
+    m_gslIntWarmChisq = 2.0;
     m_effIntNSigma = 5.0;
     m_bkgIntNSigma = 5.0;
     m_tabulateIntegral = true;
@@ -89,6 +300,7 @@ namespace LIMITS {
     setEffBkgPdfCorr(0.0);
     //
     m_minMuProb = 1e-6;
+    m_logLhRatio = false;
     //
     m_bestMuStep = 0.01;
     m_bestMuNmax = 20;
@@ -117,6 +329,65 @@ namespace LIMITS {
     m_rejs0P = 0;
     m_rejs0N1 = 0;
     m_rejs0N2 = 0;
+    //
+    clrStageClocks();
+  }
+
+  void Pole::copySetup( const Pole & other ) {
+    //
+    // Copies the settings but not the state of the calculation.
+    // The measurement is rebuilt using the setters, hence the nuisance parameters
+    // are not shared with the other instance.
+    //
+    if (this == &other) return;
+    m_poisson  = other.m_poisson;
+    m_gauss    = other.m_gauss;
+    m_gauss2d  = other.m_gauss2d;
+    m_logNorm  = other.m_logNorm;
+    m_constVal = other.m_constVal;
+    //
+    m_verbose       = other.m_verbose;
+    m_printLimStyle = other.m_printLimStyle;
+    m_cl            = other.m_cl;
+    m_method        = other.m_method;
+    m_coverage      = other.m_coverage;
+    //
+    setNObserved( other.getNObserved() );
+    setEffPdfScale( other.getEffScale() );
+    setEffPdf( other.getEffPdfMean(), other.getEffPdfSigma(), other.getEffPdfDist() );
+    setEffObs( other.getEffObs() );
+    setBkgPdfScale( other.getBkgScale() );
+    setBkgPdf( other.getBkgPdfMean(), other.getBkgPdfSigma(), other.getBkgPdfDist() );
+    setBkgObs( other.getBkgObs() );
+    setEffBkgPdfCorr( other.getEffPdfBkgCorr() );
+    setTrueSignal( other.getTrueSignal() );
+    //
+    m_intType          = other.m_intType;
+    m_gslIntNCalls     = other.m_gslIntNCalls;
+    m_gslIntWarmCalls  = other.m_gslIntWarmCalls;
+    m_gslIntWarmChisq  = other.m_gslIntWarmChisq;
+    m_effIntNSigma     = other.m_effIntNSigma;
+    m_bkgIntNSigma     = other.m_bkgIntNSigma;
+    m_intTabSRange.copy( other.m_intTabSRange );
+    m_intTabNRange.copy( other.m_intTabNRange );
+    m_tabulateIntegral = other.m_tabulateIntegral;
+    setTabInterpolation(other.getTabInterpolation());
+    setTabGrowth(other.getTabGrowth());
+    setTabDerivs(other.getTabDerivs());
+    setTabStorage(other.getTabStorage(),other.getTabBandThreshold());
+    m_poleIntFixed.unbind(); // bound to our own table by initTabIntegral()
+    //
+    m_hypTest.copy( other.m_hypTest );
+    m_bestMuStep    = other.m_bestMuStep;
+    m_bestMuNmax    = other.m_bestMuNmax;
+    m_minMuProb     = other.m_minMuProb;
+    m_logLhRatio    = other.m_logLhRatio;
+    m_thresholdBS   = other.m_thresholdBS;
+    m_thresholdPrec = other.m_thresholdPrec;
+    m_normMaxDiff   = other.m_normMaxDiff;
+    m_scaleLimit    = other.m_scaleLimit;
+    //
+    m_validBestMu = false;
   }
 
   void Pole::execute() {
@@ -137,6 +408,11 @@ namespace LIMITS {
     } else {
       printFailureMsg();
     }
+    if (m_inputFile.size()==0) { // see exeFromFile() for the summary
+      PoleStat stat;
+      getStat(stat);
+      stat.printIntStat();
+    }
   }
 
   void Pole::exeFromFile() {
@@ -156,6 +432,7 @@ namespace LIMITS {
     int nlines=0;
     TOOLS::Timer loopTime;
     loopTime.start();
+    m_metrics.start();
     bool notDone=true;
     //
     while (notDone && ((nch=inpf.peek())>-1)) {
@@ -202,6 +479,17 @@ namespace LIMITS {
           exeEvent(first);
           first=false;
           nlines++;
+          if (m_metrics.isDue()) {
+            m_metrics.clear();
+            m_metrics.add("status","running");
+            m_metrics.add("lines",nlines);
+            m_metrics.add("lines_per_s",(m_metrics.getElapsed()>0 ? double(nlines)/m_metrics.getElapsed():0.0));
+            m_metrics.add("nobs",n);
+            m_metrics.add("eff_obs",getEffObs());
+            m_metrics.add("bkg_obs",getBkgObs());
+            addMetrics(m_metrics);
+            m_metrics.write();
+          }
           if ((m_inputFileLines>0) && (nlines>=m_inputFileLines)) notDone = false; // enough lines read
         } else {
           if (nskipped<10) {
@@ -214,6 +502,17 @@ namespace LIMITS {
     loopTime.stop();
     loopTime.printUsedTime();
     loopTime.printUsedClock(nlines);
+    PoleStat stat;
+    getStat(stat);
+    stat.printIntStat();
+    if (m_metrics.isActive()) {
+      m_metrics.clear();
+      m_metrics.add("status","done");
+      m_metrics.add("lines",nlines);
+      m_metrics.add("lines_per_s",(m_metrics.getElapsed()>0 ? double(nlines)/m_metrics.getElapsed():0.0));
+      addMetrics(m_metrics);
+      m_metrics.write();
+    }
     if (first) {
       std::cout << "Failed processing any lines in the given input file." << std::endl;
     }
@@ -332,6 +631,8 @@ namespace LIMITS {
     m_bestMuProb.resize(m_nBeltUsed,0.0);
     m_bestMu.resize(m_nBeltUsed,0.0);
     m_lhRatio.resize(m_nBeltUsed,0.0);
+    m_logMuProb.resize(m_nBeltUsed,-HUGE_VAL);
+    m_logBestMuProb.resize(m_nBeltUsed,-HUGE_VAL);
     //  }
   }
 
@@ -373,9 +674,15 @@ namespace LIMITS {
                   << " ntst = " << ntst << " [" << sMin << "," << sMax << "] => ";
       }
       int imax=-10;
+      if (ntst>0) {
+        m_scanMu.resize(ntst);
+        m_scanProb.resize(ntst);
+        for (i=0;i<ntst;i++) m_scanMu[i] = sMin + i*dmus;
+        calcProbs(n,&m_scanMu[0],&m_scanProb[0],ntst);
+      }
       for (i=0;i<ntst;i++) {
-        mu_test = sMin + i*dmus;
-        lh_test = calcProb(n,mu_test);
+        mu_test = m_scanMu[i];
+        lh_test = m_scanProb[i];
         if(lh_test > lh_max) {
           imax = i;
           lh_max = lh_test;
@@ -425,15 +732,18 @@ namespace LIMITS {
       if (m_verbose>1) std::cout <<"s_best = " << mu_best << ", LH = " << lh_max << std::endl;
       m_bestMu[n] = mu_best; m_bestMuProb[n] = lh_max;  
     }
+    if (m_logLhRatio) m_logBestMuProb[n] = calcLogProb(n,m_bestMu[n]);
   }
 
 
   void Pole::findAllBestMu() {
     if (m_validBestMu) return;
+    clock_t t0 = clock();
     // fills m_bestMuProb and m_bestMu (L(s_best + b)[n])
     for (int n=0; n<m_nBeltUsed; n++) {
       findBestMu(n);
     }
+    m_clockBestMu += clock()-t0;
     if (m_verbose>2) {
       std::cout << "First 10 from best fit (mean,prob):" << std::endl;
       std::cout << m_bestMu.size() << ":" << m_bestMuProb.size() << std::endl;
@@ -455,26 +765,45 @@ namespace LIMITS {
     // A : 1.0 - normp < minprob
     // B : |p-p(prev)| < minprob^2
     // always: n>int(s)
+    // B also requires to be in the tail: p < minprob and past the mode, p(N|s) < p(N-1|s)
+    // - for a large background, p underflows below the mode and B is met too early
+    // - for an integer mean, p(N) = p(N-1) at the mode (up to rounding) and B is met with normp << 1
+    // in linear space, a tail that has underflowed to 0 (normp>0) is past the mode
+    // with constant eff and bkg, p(N|s) is taken from one Poisson column
+    const int ncol = calcProbColumn(s);
     pprev = 0;
     while (!upNfound) {
       n++;
       if ( m_muProb.size() == static_cast<size_t>(n) ) {
         m_muProb.push_back(0);
         m_lhRatio.push_back(0);
+        m_logMuProb.push_back(-HUGE_VAL);
+        m_logBestMuProb.push_back(-HUGE_VAL);
         if (usesFHC2()) {
           m_bestMu.push_back(0.0);
           m_bestMuProb.push_back(0.0);
           findBestMu(n);
         }
       }
-      p = calcProb(n,s);
+      if (m_logLhRatio) {
+        m_logMuProb[n] = (n<ncol ? m_colProb[n] : calcLogProb(n,s));
+        p = std::exp(m_logMuProb[n]); // only needed for the sums
+      } else {
+        p = (n<ncol ? m_colProb[n] : calcProb(n,s));
+      }
       m_muProb[n] = p;
       normp += p;
       dp = fabs(p - pprev);
+      const bool pastMode = (m_logLhRatio ?
+                             ((n>0) && (m_logMuProb[n]<m_logMuProb[n-1])) :
+                             ((p<pprev) || ((p==0.0) && (normp>0.0))));
       pprev = p;
       upNfound = ( (n>static_cast<int>(s)) &&
                    ((1.0-normp<m_minMuProb) ||
-                    (dp<m_minMuProb*m_minMuProb)) );
+                    ((dp<m_minMuProb*m_minMuProb) && (p<m_minMuProb))) );
+      if (upNfound) {
+        upNfound = pastMode;
+      }
     }
     //
     // * loop over calculated probs and renormalize.
@@ -482,11 +811,25 @@ namespace LIMITS {
     // * calculate likelihood ratio
     // * the renormalization makes sure that the conditions for finding
     //   an upper N will always be met
-    //
+    // * entries above n are left from a previous call with a larger belt - clear them
+    // * in log space, R is replaced by ln(R) - the ordering is the same, but
+    //   it does not underflow in the tails
+    //
+    const double rZero = (m_logLhRatio ? -HUGE_VAL : 0.0);
+    for (size_t i=n+1; i<m_muProb.size(); i++) {
+      m_muProb[i]  = 0.0;
+      m_lhRatio[i] = rZero;
+      if (m_logLhRatio) m_logMuProb[i] = -HUGE_VAL;
+    }
+    const double lognorm = std::log(normp);
     double sump=0;
-    for (size_t i=0; i<m_muProb.size(); i++) {
+    for (size_t i=0; i<=static_cast<size_t>(n); i++) {
       m_muProb[i]     /= normp; // renormalize
       m_bestMuProb[i] /= normp; // renormalize
+      if (m_logLhRatio) {
+        m_logMuProb[i]     -= lognorm;
+        m_logBestMuProb[i] -= lognorm;
+      }
       sump += m_muProb[i];
       // lower N is found if accumulated probability is > minMuProb
       if ((!lowNfound) && (sump>m_minMuProb)) {
@@ -500,16 +843,25 @@ namespace LIMITS {
           nbMax = i;
         }
       }
-      double lhSbest = getLsbest(i);
-      if (lhSbest>0) {
-        m_lhRatio[i]  = m_muProb[i]/lhSbest;
+      if (m_logLhRatio) {
+        double logLhSbest = getLogLsbest(i);
+        if (logLhSbest>-HUGE_VAL) {
+          m_lhRatio[i] = m_logMuProb[i] - logLhSbest;
+        } else {
+          m_lhRatio[i] = -HUGE_VAL;
+        }
       } else {
-        m_lhRatio[i]  = 0.0;
+        double lhSbest = getLsbest(i);
+        if (lhSbest>0) {
+          m_lhRatio[i]  = m_muProb[i]/lhSbest;
+        } else {
+          m_lhRatio[i]  = 0.0;
+        }
       }
     }
     if (nbMin<m_nBeltMinUsed) m_nBeltMinUsed = nbMin;
     if (nbMax>m_nBeltMaxUsed) m_nBeltMaxUsed = nbMax;
-    m_nBeltUsed = nbMax;
+    m_nBeltUsed = nbMax+1; // number of N used, [0,nbMax]
     return normp;
   }
 
@@ -653,7 +1005,7 @@ namespace LIMITS {
         std::cout << "--- Belt used for RL does not contain N(obs) - skip. Belt = [ "
                   << nBeltMin << " : " << nBeltMax << " ]" << std::endl;
       }
-      m_lhRatio[k]   = 0.0;
+      m_lhRatio[k]   = (m_logLhRatio ? -HUGE_VAL : 0.0);
       m_sumProb      = 1.0; // should always be >CL
       m_scanBeltNorm = 1.0;
       prec           = 1.0;
@@ -769,7 +1121,7 @@ namespace LIMITS {
           std::cout << "\t";
           TOOLS::coutFixed(6,i);
           std::cout << "\t";
-          TOOLS::coutFixed(6,m_lhRatio[i]);
+          TOOLS::coutFixed(6,(m_logLhRatio ? std::exp(m_lhRatio[i]) : m_lhRatio[i]));
           std::cout << "\t";
           TOOLS::coutFixed(6,m_muProb[i]);
           std::cout << "\t";
@@ -998,8 +1350,10 @@ namespace LIMITS {
   }
 
   void Pole::calcNMin() { // calculates the minimum N rejecting s = 0.0
+    clock_t t0 = clock();
     m_nBeltMinLast = 0;
     m_rejs0P = calcBelt(0.0,m_rejs0N1,m_rejs0N2,false,false);//,-1.0);
+    m_clockBelt += clock()-t0;
   }
 
   void Pole::calcBelt() {
@@ -1903,6 +2257,61 @@ namespace LIMITS {
     return true;
   }
 
+  double Pole::calcExactCoverage() {
+    //
+    // If both efficiency and background are constant, N(obs) is the only random
+    // variable of an experiment. The construction is then identical for all
+    // pseudo-experiments and the coverage at s(true) is simply
+    //
+    //   C(s) = sum P(N|s) over all N accepted by calcCoverageLimit()
+    //
+    // N is accepted if N >= N1(s=0) and the sum of P(i|s) for all i with R(i)>R(N)
+    // is below the CL - i.e the same criterion as in calcLimit().
+    //
+    if (!hasConstNuisances()) {
+      std::cout << "ERROR: calcExactCoverage() requires constant efficiency and background!" << std::endl;
+      return -1.0;
+    }
+    if (usesFHC2()) findAllBestMu();
+    resetCalcLimit();
+    calcNMin();
+    //
+    int nBeltMin, nBeltMax;
+    double s = getTrueSignal();
+    calcLhRatio(s,nBeltMin,nBeltMax);
+    //
+    // order the N in the belt according to decreasing R
+    //
+    std::vector<double> lhr;
+    std::vector<int>    index;
+    for (int n=nBeltMin; n<=nBeltMax; n++) lhr.push_back(m_lhRatio[n]);
+    sort_index(lhr,index,true);
+    //
+    // loop over groups of equal R - the probability above a group is what decides
+    // whether its members are accepted or not
+    //
+    double sumAbove = 0.0;
+    double coverage = 0.0;
+    size_t i = 0;
+    while (i<index.size()) {
+      size_t j = i;
+      double sumGroup = 0.0;
+      while ((j<index.size()) && (lhr[index[j]]==lhr[index[i]])) {
+        int n = index[j]+nBeltMin;
+        if ((sumAbove<m_cl) && (n>=m_rejs0N1)) coverage += m_muProb[n];
+        sumGroup += m_muProb[n];
+        j++;
+      }
+      sumAbove += sumGroup;
+      i = j;
+    }
+    if (m_verbose>2) {
+      std::cout << "Exact coverage: true s = " << s << " belt = [ " << nBeltMin << " : " << nBeltMax
+                << " ] coverage = " << coverage << std::endl;
+    }
+    return coverage;
+  }
+
   void Pole::resetCalcLimit() {
     m_maxNorm = -1.0;
     m_lowerLimitFound = false;
@@ -2041,10 +2450,13 @@ namespace LIMITS {
       TOOLS::calcIntRange( *(m_measurement.getBkg()), m_bkgIntNSigma, xl[bi],xu[bi] );
 
     // init the integrator
-    m_poleIntegrator.integrator()->setFunction( poleFun );
+    m_poleIntegrator.setIntType(m_intType);
+    m_poleIntegrator.integrator()->setFunction( m_poleIntegrator.selectFunction() );
+    m_poleIntegrator.integrator()->setBatchFunction( m_poleIntegrator.selectBatchFunction() );
     m_poleIntegrator.integrator()->setFunctionDim(ndim);
     m_poleIntegrator.integrator()->setIntRanges(xl,xu);
     m_poleIntegrator.integrator()->setNcalls(m_gslIntNCalls);
+    m_poleIntegrator.vegas()->setWarmStart(m_gslIntWarmCalls,m_gslIntWarmChisq);
     std::vector<double> dummy(2,0); // the '2' here refers to dummy[0] = N(obs) and dummy[1] = signal
     m_poleIntegrator.setParameters(dummy); // will also setFunctionParams()
     m_poleIntegrator.integrator()->initialize();
@@ -2068,18 +2480,37 @@ namespace LIMITS {
                                  static_cast<double>(m_intTabNRange.max()),
                                  1.0,
                                  s_tabNobsInd);
-
+    // s contiguous: the interpolation in s reads neighbouring nodes, and tabbench shows that
+    // it is as fast or faster than N contiguous for both the belt (n loop) and the s(best) scan
+    std::vector<size_t> order(2);
+    order[0] = s_tabNobsInd;
+    order[1] = s_tabSigInd;
+    m_poleIntTable.setTabAxisOrder(order);
+
+    m_poleIntFixed.unbind();
     if (m_tabulateIntegral) {
       TOOLS::Timer tt;
-      PDF::gPrintStat = true;
       std::cout << std::endl;
       if (getObsPdf()) getObsPdf()->clrStat();
       if (getEffPdf()) getEffPdf()->clrStat();
       if (getBkgPdf()) getBkgPdf()->clrStat();
+      const unsigned long nWarm    = m_poleIntegrator.getVegas()->getNWarm();
+      const unsigned long nReadapt = m_poleIntegrator.getVegas()->getNReadapt();
+      const unsigned long nBudget  = m_poleIntegrator.getCubature()->getNBudgetStops();
       tt.start("Tabulating integral : ");
       m_poleIntTable.tabulate();
+      updateTabRange();
       tt.stop();
+      m_clockTabulate += tt.getStopClock()-tt.getStartClock();
       tt.printUsedClock();
+      if (m_poleIntegrator.getVegas()->getNWarm()>nWarm) {
+        std::cout << "Vegas warm start    : " << m_poleIntegrator.getVegas()->getNWarm()-nWarm << " cells, "
+                  << m_poleIntegrator.getVegas()->getNReadapt()-nReadapt << " re-adapted on a new grid" << std::endl;
+      }
+      if (m_poleIntegrator.getCubature()->getNBudgetStops()>nBudget) {
+        std::cout << "WARNING: cubature  : " << m_poleIntegrator.getCubature()->getNBudgetStops()-nBudget
+                  << " cells reached --gslintncalls before the tolerance - increase it" << std::endl;
+      }
       std::cout << std::endl;
       if (getObsPdf()) {
          std::cout << "Obs PDF statistics: " << std::endl;
@@ -2093,7 +2524,6 @@ namespace LIMITS {
          std::cout << "Bkg PDF statistics: " << std::endl;
          getBkgPdf()->printStat();
       }
-      PDF::gPrintStat = false;
     }
   }
 
@@ -2129,11 +2559,15 @@ namespace LIMITS {
     if (m_verbose>0) {
       thetime.start(msgB.c_str());
     }
+    clock_t t0     = clock();
+    clock_t tbelt0 = m_clockBelt;
     if (m_coverage) {
       rval=calcCoverageLimit();
     } else {
       rval=calcLimit();
     }
+    m_clockLimit += (clock()-t0) - (m_clockBelt-tbelt0);
+    m_nAnalysed++;
     if (m_verbose>0) {
       thetime.stop();
       thetime.printUsedClock(0,msgC.c_str());
@@ -2144,6 +2578,230 @@ namespace LIMITS {
     return rval;
   }
 
+  void Pole::updateTabRange() {
+    m_poleIntTabExtends = m_poleIntTable.getStatNextend();
+    // such that the next initTabIntegral() makes the extended table from the start
+    setIntSigRange(m_poleIntTable.getTabMin(s_tabSigInd), m_poleIntTable.getTabMax(s_tabSigInd),
+                   static_cast<int>(m_poleIntTable.getTabNsteps(s_tabSigInd)));
+    setIntNobsRange(static_cast<int>(m_poleIntTable.getTabMin(s_tabNobsInd)+0.5),
+                    static_cast<int>(m_poleIntTable.getTabMax(s_tabNobsInd)+0.5));
+    // the default interpolation is the Taylor expansion in s of interpolate()
+    if (m_poleIntTable.getInterpolation()==ITabulator::INTERP_DEFAULT)
+      m_poleIntFixed.bind(m_poleIntTable, ITabulator::INTERP_TAYLOR, 1u<<s_tabSigInd);
+    else
+      m_poleIntFixed.bind(m_poleIntTable);
+  }
+
+  double Pole::calcProbDirect( int n, double s, double & err ) {
+    std::vector<double> pars(2);
+    pars[s_tabSigInd]  = s;
+    pars[s_tabNobsInd] = static_cast<double>(n);
+    m_poleIntegrator.setParameters(pars);
+    m_poleIntegrator.go();
+    err = m_poleIntegrator.getIntegrator()->error();
+    return m_poleIntegrator.result();
+  }
+
+  double Pole::getTabMuMax() const {
+    return m_intTabSRange.max()*getEffIntMax()*getEffScale() + getBkgIntMax()*getBkgScale();
+  }
+
+  double Pole::getTabMuStep() const {
+    return m_intTabSRange.step()*getEffObs()*getEffScale();
+  }
+
+  bool Pole::planTabIntegral( double prec, int nobsMax ) {
+    if (prec<=0.0) return false;
+    if (nobsMax<0) nobsMax = getNObserved();
+    initIntegral(); // integration ranges of eff and bkg
+    const double effObs = getEffObs()*getEffScale();
+    const double effLo  = std::max(getEffIntMin(),0.5*getEffObs())*getEffScale();
+    const double effHi  = getEffIntMax()*getEffScale();
+    const double bkgObs = getBkgObs()*getBkgScale();
+    const double bkgLo  = getBkgIntMin()*getBkgScale();
+    const double bkgHi  = getBkgIntMax()*getBkgScale();
+    if ((effObs<=0.0) || (effLo<=0.0)) {
+      std::cout << "ERROR: cannot plan the integral table with efficiency <= 0 - table unchanged" << std::endl;
+      return false;
+    }
+    //
+    // ranges: s above the upper limit for nobsMax, N over the belt of the largest s
+    //
+    const double nup  = static_cast<double>(nobsMax)+1.0;
+    double       sMax = std::max(nup+3.0*std::sqrt(nup)-bkgLo,1.0)/effLo;
+    const double muHi = sMax*effHi+bkgHi;
+    const int    nMax = static_cast<int>(muHi+5.0*std::sqrt(muHi)+5.0);
+    //
+    // error per cell such that the sum over the belt (~ +-3 sigma in N) is within prec*(1-CL)
+    //
+    const double width  = 1.0+6.0*std::sqrt(nup);
+    const double budget = prec*(1.0-m_cl)/width;
+    //
+    // pilot cells: s over the range, N at the mode of P(N|s) and at +-1 sigma - there the
+    // derivatives in s are the largest. Also N(obs) at small s.
+    //
+    std::vector<int>    pilotN;
+    std::vector<double> pilotS;
+    for (int k=0; k<=4; k++) {
+      const double sp = 0.25*static_cast<double>(k)*sMax;
+      const double mu = effObs*sp+bkgObs;
+      for (int j=-1; j<=1; j++) {
+        const int n = static_cast<int>(mu+static_cast<double>(j)*std::sqrt(mu)+0.5);
+        if ((n>=0) && (n<=nMax)) {
+          pilotN.push_back(n);
+          pilotS.push_back(sp);
+        }
+      }
+    }
+    pilotN.push_back(nobsMax);
+    pilotS.push_back(0.0);
+    //
+    // interpolation along s as in calcProb()
+    //
+    ITabulator::INTERP interp = getTabInterpolation();
+    if (interp==ITabulator::INTERP_DEFAULT) interp = ITabulator::INTERP_TAYLOR;
+    size_t first;
+    double w[4];
+    const int nw = tabAxisWeights(interp, 2.5, 5, first, w); // halfway between nodes 2 and 3 of 5
+    //
+    // integration noise and time per integral, from one integral per pilot cell
+    //
+    const bool exact = m_poleIntegrator.isConstant();
+    const bool proxy = ((!exact) && (m_poisson!=0));
+    clock_t tint  = clock();
+    double  noise = 0.0;
+    for (size_t i=0; i<pilotN.size(); i++) {
+      double ep;
+      calcProbDirect(pilotN[i],pilotS[i],ep);
+      if (2.0*ep>noise) noise = 2.0*ep;
+    }
+    tint = clock()-tint;
+    int nint = static_cast<int>(pilotN.size());
+    //
+    // halve the step until the largest error in the pilot cells is within the budget.
+    // With uncertainties on eff or bkg, the integral is noisy and the step is chosen with
+    // P(n|s) at the observed eff and bkg - this is sharper than the integral, hence conservative.
+    //
+    double  step    = sMax/20.0;
+    double  err     = 0.0;
+    double  errPrev = -1.0;
+    const int maxHalve = 14;
+    int nhalve;
+    for (nhalve=0; nhalve<maxHalve; nhalve++) {
+      err = 0.0;
+      for (size_t i=0; i<pilotN.size(); i++) {
+        const double s0 = std::max(pilotS[i]-2.5*step,0.0);
+        double f[6];
+        const clock_t t0 = clock();
+        for (int j=0; j<6; j++) {
+          const double sj = s0+(j<5 ? static_cast<double>(j):2.5)*step;
+          double ej;
+          f[j] = (proxy ? m_poisson->getVal(pilotN[i],effObs*sj+bkgObs) : calcProbDirect(pilotN[i],sj,ej));
+        }
+        if (!proxy) {  // the Poisson proxy is not an integral - not in the time per integral
+          nint += 6;
+          tint += clock()-t0;
+        }
+        double fi = 0.0;
+        for (int k=0; k<nw; k++) fi += w[k]*f[first+k];
+        const double d = std::fabs(fi-f[5]);
+        if (d>err) err = d;
+      }
+      if (err<=budget) break;
+      errPrev = err;
+      step *= 0.5;
+    }
+    const double tEval = (nint>0 ? static_cast<double>(tint)/(CLOCKS_PER_SEC*static_cast<double>(nint)) : 0.0);
+    //
+    // between the last two steps, using the order of the interpolation error from their errors
+    //
+    if ((nhalve<maxHalve) && (errPrev>budget) && (err>0.0)) {
+      double order = std::log(errPrev/err)/std::log(2.0);
+      if (order<1.0) order = 1.0;
+      if (order>4.0) order = 4.0;
+      const double grow = std::min(1.9,0.9*std::pow(budget/err,1.0/order));
+      if (grow>1.0) step *= grow;
+    }
+    const int nsteps = static_cast<int>(std::ceil(sMax/step))+1;
+    sMax = static_cast<double>(nsteps-1)*step;
+    setIntSigRange(0.0,sMax,nsteps);
+    setIntNobsRange(0,nMax);
+    setTabulateIntegral(true);
+    //
+    // cost
+    //
+    const double ncells = static_cast<double>(nsteps)*static_cast<double>(nMax+1);
+    double memory = ncells*sizeof(double)*(getTabDerivs() ? 4.0:1.0);
+    if ((getTabStorage()==ITabulator::STORE_FLOAT) || (getTabStorage()==ITabulator::STORE_BAND_FLOAT))
+      memory -= ncells*(sizeof(double)-sizeof(float));
+    std::ios_base::fmtflags old = std::cout.flags();
+    std::streamsize oldPrec = std::cout.precision();
+    std::cout << "\n--- INTEGRAL TABLE PLAN -------------------------------------------" << std::endl;
+    std::cout << " Precision on 1-CL    : " << prec << "  (max error per cell " << budget << ")" << std::endl;
+    std::cout << " Pilot cells          : " << pilotN.size() << " ; " << nint << " integrals in "
+              << static_cast<int>(1000.0*tEval*nint+0.5) << " ms" << std::endl;
+    std::cout << " N(obs)               : 0 - " << nMax << std::endl;
+    std::cout << " Signal               : 0 - " << sMax << " ; step " << step << " (" << nsteps << " steps)" << std::endl;
+    if (nhalve>=maxHalve) {
+      std::cout << " WARNING: error " << err << " above the budget at the smallest step" << std::endl;
+    } else {
+      std::cout << " Pilot max error      : " << err << (proxy ? " (Poisson at the observed eff and bkg)":"") << std::endl;
+    }
+    if (!exact) {
+      std::cout << " Integration noise    : " << noise << " (2 sigma)" << std::endl;
+    }
+    if (noise>budget)
+      std::cout << " NOTE: the integration noise is above the budget - increase --gslintncalls for this precision" << std::endl;
+    std::cout << " Cells                : " << static_cast<long>(ncells) << " ; memory " << static_cast<long>(memory/1024.0)
+              << " kB ; tabulation time ~" << std::setprecision(3) << ncells*tEval << " s" << std::endl;
+    std::cout << "-------------------------------------------------------------------\n" << std::endl;
+    std::cout.flags(old);
+    std::cout.precision(oldPrec);
+    return true;
+  }
+
+  void Pole::clrStageClocks() {
+    m_clockTabulate = 0;
+    m_clockBestMu   = 0;
+    m_clockBelt     = 0;
+    m_clockLimit    = 0;
+    m_nAnalysed     = 0;
+    m_poleIntFixedHits = 0;
+  }
+
+  void Pole::getStat( PoleStat & stat ) const {
+    stat.nAnalysed     = m_nAnalysed;
+    stat.timeTabulate  = getTimeTabulate();
+    stat.timeBestMu    = getTimeBestMu();
+    stat.timeBelt      = getTimeBelt();
+    stat.timeLimit     = getTimeLimit();
+    stat.nIntegrations = m_poleIntegrator.getIntegrator()->getNIntegrations();
+    stat.intBudgetStops = m_poleIntegrator.getCubature()->getNBudgetStops();
+    stat.tabBuilds     = m_poleIntTable.getStatNtabulate();
+    stat.tabHits       = m_poleIntTable.getStatNlookup()+m_poleIntFixedHits;
+    stat.tabFallbacks  = m_poleIntTable.getStatNfallback();
+    stat.tabExtends    = m_poleIntTable.getStatNextend();
+    stat.tabDirect     = m_poleIntTable.getStatNdirect();
+  }
+
+  void Pole::addMetrics( TOOLS::MetricsFile & metrics ) const {
+    PoleStat stat;
+    getStat(stat);
+    stat.addMetrics(metrics);
+    addPoissonMetrics(metrics);
+  }
+
+  void Pole::addPoissonMetrics( TOOLS::MetricsFile & metrics ) const {
+    const ITabulator *poisTab = (m_poisson ? m_poisson->getTabulator() : 0);
+    if (poisTab) {
+      PDF::Stat stat;
+      m_poisson->getStat(stat); // summed over all threads
+      metrics.add("poistab_builds",   poisTab->getStatNtabulate());
+      metrics.add("poistab_hits",     stat.ntab);
+      metrics.add("poistab_fallbacks",stat.nfallback);
+    }
+  }
+
   void Pole::printLimit(bool doTitle) {
     std::string cmtPre;
     std::string linePre;
@@ -2236,7 +2894,11 @@ namespace LIMITS {
     std::cout << "----------------------------------------------\n";
     std::cout << " Bkg-Eff correlation: " << m_measurement.getBEcorr() << std::endl;
     std::cout << "----------------------------------------------\n";
+    std::cout << " Integrator         : " << (m_intType==Integrator::INT_QMC ? "QMC (scrambled Sobol)" :
+                                               m_intType==Integrator::INT_CUBATURE ? "adaptive cubature" : "Vegas") << std::endl;
     std::cout << " GSL int. N(calls)  : " << m_gslIntNCalls << std::endl;
+    if (m_gslIntWarmCalls>0)
+      std::cout << " GSL int. warm start: " << m_gslIntWarmCalls << " calls, max chi2/dof " << m_gslIntWarmChisq << std::endl;
     std::cout << "----------------------------------------------\n";
     std::cout << " Int. eff. min      : " << getEffIntMin() << std::endl;
     std::cout << "           max      : " << getEffIntMax() << std::endl;
@@ -2253,11 +2915,18 @@ namespace LIMITS {
       std::cout << " Tab. S min         : " << m_intTabSRange.min()  << std::endl;
       std::cout << "        max         : " << m_intTabSRange.max()  << std::endl;
       std::cout << "        step        : " << m_intTabSRange.step() << std::endl;
+      std::cout << " Tab. growth        : " << getTabGrowth() << std::endl;
+      std::cout << " Tab. derivatives   : " << TOOLS::yesNo(getTabDerivs()) << std::endl;
+      std::cout << " Tab. in float      : " << TOOLS::yesNo((getTabStorage()==ITabulator::STORE_FLOAT) ||
+                                                            (getTabStorage()==ITabulator::STORE_BAND_FLOAT)) << std::endl;
+      if ((getTabStorage()==ITabulator::STORE_BAND) || (getTabStorage()==ITabulator::STORE_BAND_FLOAT))
+        std::cout << " Tab. band threshold: " << getTabBandThreshold() << std::endl;
     }
     std::cout << "----------------------------------------------\n";
     std::cout << " Binary search thr. : " << m_thresholdBS << std::endl;
     std::cout << " 1-CL threshold     : " << m_thresholdPrec << std::endl;
     std::cout << " Min prob in belt   : " << m_minMuProb << std::endl;
+    std::cout << " Log-space LH ratio : " << TOOLS::yesNo(m_logLhRatio) << std::endl;
     std::cout << "----------------------------------------------\n";
     std::cout << " *Test hyp. min     : " << m_hypTest.min() << std::endl;
     std::cout << " *Test hyp. max     : " << m_hypTest.max() << std::endl;
@@ -157,8 +157,27 @@ namespace LIMITS {
     double           deffObs;
     double           bkgObs;
     double           dbkgObs;
+    double           effPar[3]; // loop invariant terms of pdfEff, see selectPoleFun()
+    double           bkgPar[3]; // idem, pdfBkg
   };
 
+  //! integrand signature used by Integrator
+  typedef double (*PoleFunPtr)(double *k, size_t dim, void *params);
+  //! batch integrand signature, see Integrator::setBatchFunction()
+  typedef Integrator::BatchFunction PoleFunBatchPtr;
+  //! generic integrand - virtual pdf calls
+  double poleFun(double *k, size_t dim, void *params);
+  //! batch version of poleFun()
+  void poleFunBatch(double *k, size_t npts, size_t dim, void *params, double *f);
+  /*!
+    Select the integrand instantiated for the (eff,bkg) pdf pair of pd,
+    and fill the loop invariant terms pd.effPar and pd.bkgPar.
+    Falls back to poleFun() if the observable is not Poisson.
+  */
+  PoleFunPtr selectPoleFun( PoleData & pd );
+  //! batch version of selectPoleFun()
+  PoleFunBatchPtr selectPoleFunBatch( PoleData & pd );
+
   class PoleIntegrator {
   public:
     inline PoleIntegrator();
@@ -167,12 +186,30 @@ namespace LIMITS {
     inline void setPole( const Pole *pole );
 
     inline void setParameters( std::vector<double> & pars );
-
+    //! integrand for the current pdfs - call after setPole()
+    inline PoleFunPtr selectFunction();
+    //! batch integrand for the current pdfs - call after setPole()
+    inline PoleFunBatchPtr selectBatchFunction();
+
+    //! select the integrator used by integrator() and go()
+    inline void setIntType( Integrator::TYPE t ) { m_intType = t; }
+    inline Integrator::TYPE getIntType() const   { return m_intType; }
     inline const Integrator *getIntegrator() const;
     inline Integrator       *integrator();
+    inline const IntegratorVegas *getVegas() const;
+    inline IntegratorVegas       *vegas();
+    inline const IntegratorCubature *getCubature() const;
     //
     inline void   go();
     inline double result() const;
+    //! true if eff and bkg are constant - the integral is then a single evaluation
+    inline bool   isConstant()   const;
+    //! p[i] = integral for N(obs)=n and signal s[i], i=0..ns-1 - requires isConstant()
+    inline void   getValues( int n, const double *s, double *p, size_t ns );
+    //! log of the integral for N(obs)=n and signal s - requires isConstant()
+    inline double getLogValue( int n, double s ) const;
+    //! p[n] = integral (or its log) for N(obs)=n=0..size-1 from one Poisson column - returns size
+    inline int    getColumn( double s, std::vector<double> & p, bool logp ) const;
 
     inline int    getEffIndex()  const;
     inline double getEffIntMin() const;
@@ -182,10 +219,43 @@ namespace LIMITS {
     inline double getBkgIntMax() const; 
   private:
     struct PoleData m_poleData;
+    Integrator::TYPE m_intType;
     IntegratorVegas m_integrator;
+    IntegratorQMC   m_integratorQMC;
+    IntegratorCubature m_integratorCubature;
+    std::vector<double> m_lambda; // buffer for getValues()
   };
 
 
+  /*! @struct PoleStat
+
+    @brief Run time statistics of one Pole instance, see Pole::getStat()
+
+  */
+  struct PoleStat {
+    PoleStat() { clear(); }
+    inline void clear();
+    inline void add( const PoleStat & other );
+    inline void addMetrics( TOOLS::MetricsFile & metrics ) const;
+    //! print the table usage - warns if values were integrated outside the table, see also printIntStat()
+    inline void printTabStat() const;
+    //! warns if integrals were ended by the call budget before the tolerance
+    inline void printIntStat() const;
+    //
+    int           nAnalysed;     /**< calls to analyseExperiment() */
+    double        timeTabulate;  /**< CPU time (s) tabulating the integral */
+    double        timeBestMu;    /**< idem, findAllBestMu() */
+    double        timeBelt;      /**< idem, calcNMin() */
+    double        timeLimit;     /**< idem, limit scan excluding calcNMin() */
+    unsigned long nIntegrations; /**< integrator calls */
+    unsigned long intBudgetStops; /**< idem, ended by the call budget before the tolerance (cubature) */
+    unsigned long tabBuilds;     /**< pole integral table: tabulate() calls */
+    unsigned long tabHits;       /**< idem: values from table */
+    unsigned long tabFallbacks;  /**< idem: out of range */
+    unsigned long tabExtends;    /**< idem: extensions */
+    unsigned long tabDirect;     /**< idem: table not made */
+  };
+
   enum RLMETHOD {
     RL_NONE=0,
     RL_FHC2,
@@ -231,10 +301,18 @@ namespace LIMITS {
     void setInputFile( const char *s ) { m_inputFile = s; }
     //! Set the number of lines to read from the input file
     void setInputFileLines( int nmax ) { m_inputFileLines = nmax; }
+    //! Set metrics file written every dt seconds by exeFromFile() - no file if name is empty
+    void setMetricsFile( const char *name, int dt=30 ) { m_metrics.setFileName(name); m_metrics.setInterval(dt); }
 
     //! Set measurement
     void setMeasurement( const MEAS::MeasPoisEB & m ) { m_measurement.copy(m); }
 
+    //! Copy all settings (not the results) from another instance - e.g for one instance per thread
+    void copySetup( const Pole & other );
+    //! Set the random generator used for the pseudo-experiments
+    void setRndGen( const RND::Random *rndgen ) { m_measurement.setRndGen(rndgen); }
+    const RND::Random *getRndGen() const { return m_measurement.getRndGen(); }
+
     //! set the confidence level
     void setCL(double cl)    { m_cl = cl; if ((cl>1.0)||(cl<0.0)) m_cl=0.9;}
 
@@ -322,8 +400,19 @@ namespace LIMITS {
     */
     void setIntBkgNSigma( double nsigma ) { m_bkgIntNSigma = nsigma; }
 
+    //! set the integrator - Vegas (default), randomized QMC or adaptive cubature, see IntegratorQMC, IntegratorCubature
+    void setIntType(Integrator::TYPE t) { m_intType = t; }
+    Integrator::TYPE getIntType() const { return m_intType; }
     //! set the number of calls used by GSL integrator
     void setIntGslNCalls(int n) { m_gslIntNCalls = n; }
+    /*!
+      Warm start of the Vegas integrator, see IntegratorVegas::setWarmStart().
+      Each integral uses n calls on the grid adapted for the previous one (0 => a new grid each time);
+      it is redone with setIntGslNCalls() calls on a new grid if chi2/dof > chisqMax.
+    */
+    void setIntGslWarmStart(int n, double chisqMax=2.0) { m_gslIntWarmCalls = (n>0 ? n:0); m_gslIntWarmChisq = chisqMax; }
+    int    getIntGslWarmCalls() const { return m_gslIntWarmCalls; }
+    double getIntGslWarmChisq() const { return m_gslIntWarmChisq; }
 
     //! set range in signal for tabulated integral
     void setIntSigRange( double smin, double smax, int nsteps ) { m_intTabSRange.setRange( smin, smax, 0.0, nsteps ); }
@@ -333,9 +422,31 @@ namespace LIMITS {
 
     //! set tabulation flag
     void setTabulateIntegral( bool f ) { m_tabulateIntegral = f; }
+    //! interpolation in the integral table - INTERP_DEFAULT is a Taylor expansion in the signal
+    void setTabInterpolation( ITabulator::INTERP interp ) { m_poleIntTable.setInterpolation(interp); }
+    ITabulator::INTERP getTabInterpolation() const { return m_poleIntTable.getInterpolation(); }
+    /*!
+      If growth>0, the integral table is extended by at least this fraction when (n,s) is often above its range,
+      see ITabulator::setGrowth(). The extended range is kept for the next initTabIntegral().
+      If 0, the values outside the table are always integrated directly.
+    */
+    void setTabGrowth( double growth ) { m_poleIntTable.setGrowth(growth); }
+    double getTabGrowth() const { return m_poleIntTable.getGrowth(); }
+    //! if true, the table also stores the derivatives in s, used by the Taylor and Hermite interpolation in calcProb()
+    void setTabDerivs( bool f ) { m_poleIntTable.setDerivAxis(f ? s_tabSigInd : -1); }
+    bool getTabDerivs() const { return (m_poleIntTable.getDerivAxis()>=0); }
+    /*!
+      Storage of the integral table, see ITabulator::setTabStorage(). The banded storage keeps, per N(obs),
+      the signals where the probability is above threshold - calcProb() is 0 outside.
+    */
+    void setTabStorage( ITabulator::STORAGE storage, double threshold=0.0 ) { m_poleIntTable.setTabStorage(storage,threshold); }
+    ITabulator::STORAGE getTabStorage() const { return m_poleIntTable.getTabStorage(); }
+    double getTabBandThreshold() const { return m_poleIntTable.getTabBandThreshold(); }
 
     //! set a scaling number to scale the output limits
     void setScaleLimit(double s) { m_scaleLimit = (s>0.0 ? s:1.0); }
+    //! if true, the likelihood ratio is calculated in log space, see calcLhRatio()
+    void setLogLhRatio(bool flag) { m_logLhRatio = flag; }
     //@}
 
     /*! @name Set parameters concerning the precision of the calculations */
@@ -425,6 +536,22 @@ namespace LIMITS {
     void initIntegral();
     //! init tabulated pole integral
     void initTabIntegral();
+    //! after an extension of the table by calcProb() - copy its range and rebind m_poleIntFixed
+    void updateTabRange();
+    /*!
+      Choose the range and the signal step of the integral table for the current measurement.
+      The step is such that the interpolation error, summed over the belt, is below prec*(1-CL).
+      It is found by probing the interpolation error on a few pilot cells with the integrator, or with
+      P(n|s) at the observed eff and bkg if the integral is noisy (Monte Carlo).
+      nobsMax is the largest N(obs) to be analysed (<0 => getNObserved()).
+      Prints the chosen table and its cost, and sets setIntSigRange(), setIntNobsRange().
+      Returns false if the measurement does not allow a plan (the ranges are then unchanged).
+    */
+    bool planTabIntegral( double prec, int nobsMax=-1 );
+    //! largest Poisson mean s*eff+bkg within the integral table
+    double getTabMuMax() const;
+    //! step in the Poisson mean corresponding to the signal step of the integral table
+    double getTabMuStep() const;
     //@}
 
 
@@ -432,6 +559,14 @@ namespace LIMITS {
     //@{
     //! calculate probability P(N(obs) | signal) using table
     inline double calcProb( int n, double s );
+    //! idem for an array of signals, p[i] = P(n | s[i]) - evaluated in one batch if possible
+    inline void calcProbs( int n, const double *s, double *p, size_t ns );
+    //! ln P(N(obs) | signal) - without exp() if there is no integral
+    inline double calcLogProb( int n, double s );
+    //! P(N(obs) | signal) integrated directly, err = integration error - no table
+    double calcProbDirect( int n, double s, double & err );
+    //! fills m_colProb with P(n | s) (log if m_logLhRatio) for n=0..N-1 if there is no integral - returns N
+    inline int    calcProbColumn( double s );
     //! finds all mu_best - only used if the method is RLMETHOD::RL_FHC2
     void findAllBestMu();   // dito for all n (loop n=0; n<m_nMuUsed)
     //! finds the mu_best for the given N
@@ -456,6 +591,8 @@ namespace LIMITS {
     int  calcLimit(double s) { double prec; return calcLimit(s,prec); }
     //! check if s(true) lies within the limit
     bool calcCoverageLimit();
+    //! exact coverage at s(true) - only valid if eff and bkg are constant
+    double calcExactCoverage();
     //! calculate the likelihood ratio
     double calcLhRatio(double s, int & nb1, int & nb2);
     //! calculate the power
@@ -468,6 +605,28 @@ namespace LIMITS {
     bool limitsOK();
     //@}
 
+    /*! @name Run time statistics */
+    //@{
+    //! clear the accumulated stage clocks
+    void clrStageClocks();
+    //! get table, integrator and stage statistics
+    void getStat( PoleStat & stat ) const;
+    //! add table, integrator and stage statistics to the given metrics
+    void addMetrics( TOOLS::MetricsFile & metrics ) const;
+    //! add the statistics of the tabulated Poisson (if any) to the given metrics
+    void addPoissonMetrics( TOOLS::MetricsFile & metrics ) const;
+    //! CPU time (s) spent tabulating the integral
+    const double getTimeTabulate() const { return double(m_clockTabulate)/CLOCKS_PER_SEC; }
+    //! CPU time (s) spent in findAllBestMu()
+    const double getTimeBestMu()   const { return double(m_clockBestMu)/CLOCKS_PER_SEC; }
+    //! CPU time (s) spent in calcNMin() - belt at s=0
+    const double getTimeBelt()     const { return double(m_clockBelt)/CLOCKS_PER_SEC; }
+    //! CPU time (s) spent scanning for limits (excluding the belt at s=0)
+    const double getTimeLimit()    const { return double(m_clockLimit)/CLOCKS_PER_SEC; }
+    //! number of calls to analyseExperiment()
+    const int    getNAnalysed()    const { return m_nAnalysed; }
+    //@}
+
     /*! @name Output */
     //@{
     //! set the print style - not very elaborate at the moment - can be 0 or 1
@@ -512,6 +671,7 @@ namespace LIMITS {
     const double       getEffPdfBkgCorr() const { return m_measurement.getBEcorr(); }
 
     const bool         useCoverage()      const { return m_coverage; }
+    const bool         hasConstNuisances() const { return (PDF::isConstant(getEffPdfDist()) && PDF::isConstant(getBkgPdfDist())); }
     const bool         truthCovered()     const { return m_coversTruth; }
 
     const int            getVerbose()       const { return m_verbose; }
@@ -531,6 +691,7 @@ namespace LIMITS {
 
     const double  getSbest(int n) const;
     const double  getLsbest(int n) const;
+    const double  getLogLsbest(int n) const;
     const int     getNBeltUsed() const { return m_nBeltUsed; }
     const int     getNBeltMinUsed() const { return m_nBeltMinUsed; }
     const int     getNBeltMaxUsed() const { return m_nBeltMaxUsed; }
@@ -541,7 +702,8 @@ namespace LIMITS {
     const std::vector<double> & getBestMuProb() const { return m_bestMuProb; }
     const std::vector<double> & getBestMu() const { return m_bestMu; }
     const std::vector<double> & getMuProb() const { return m_muProb; }
-    const std::vector<double> & getLhRatio() const { return m_lhRatio; }
+    const std::vector<double> & getLhRatio() const { return m_lhRatio; } // ln R if usesLogLhRatio()
+    const bool   usesLogLhRatio() const { return m_logLhRatio; }
     const double getMinMuProb() const { return m_minMuProb; }
     const double getMuProb(int n) const { if ((n>m_nBeltMaxUsed)||(n<m_nBeltMinUsed)) return 0.0; return m_muProb[n];}
     //
@@ -601,11 +763,17 @@ namespace LIMITS {
     double  m_beCorr;
 
     PoleIntegrator            m_poleIntegrator; /**< Pole Integrator wrapper class */
+    Integrator::TYPE          m_intType;        /**< integrator type */
     int                       m_gslIntNCalls;   /**< number of calls used by GSL integrator */
+    int                       m_gslIntWarmCalls; /**< idem, on a warm Vegas grid - 0 => no warm start */
+    double                    m_gslIntWarmChisq; /**< maximum chi2/dof on a warm Vegas grid */
     double                    m_effIntNSigma;   /**< defines the integration range in N(sigmas) */
     double                    m_bkgIntNSigma;   /**< for bkg */
 
     Tabulator<PoleIntegrator> m_poleIntTable;   /**< the table of poleIntegrator   */
+    TabulatorFixed<PoleIntegrator,2> m_poleIntFixed; /**< lookup in m_poleIntTable used by calcProb() */
+    unsigned long             m_poleIntFixedHits; /**< calcProb() values from m_poleIntFixed */
+    unsigned long             m_poleIntTabExtends; /**< extensions of m_poleIntTable seen by calcProb() */
     Range<double>             m_intTabSRange;   /**< tabulated signal range */
     Range<int>                m_intTabNRange;   /**< tabulated N(obs) range */
     bool                      m_tabulateIntegral; /**< flag; if true, tabulate the integral */
@@ -630,9 +798,15 @@ namespace LIMITS {
     double  m_bestMuStep;       // step size in search for s_best (LHR)
     int     m_bestMuNmax;   // maximum N in search for s_best (will locally nodify dmus)
     std::vector<double> m_bestMuProb; // prob. of best mu=e*s+b, index == (N observed)
+    std::vector<double> m_logBestMuProb; // ln of m_bestMuProb, only if m_logLhRatio
+    std::vector<double> m_scanMu;     // signals scanned in findBestMu()
+    std::vector<double> m_scanProb;   // and their probabilities
     std::vector<double> m_bestMu;     // best mu=e*s+b
     std::vector<double> m_muProb;     // prob for mu
-    std::vector<double> m_lhRatio;    // likelihood ratio
+    std::vector<double> m_lhRatio;    // likelihood ratio, or its log if m_logLhRatio
+    std::vector<double> m_logMuProb;  // ln of m_muProb, only if m_logLhRatio
+    std::vector<double> m_colProb;    // P(n|s) column, see calcProbColumn()
+    bool                m_logLhRatio; // if true, calculate ln(R) in calcLhRatio()
     double m_minMuProb;  // minimum probability accepted
     //
     double m_thresholdBS; // binary search threshold
@@ -658,11 +832,84 @@ namespace LIMITS {
 
     std::string m_inputFile; // input file with data
     int         m_inputFileLines; // number of lines to read; if < 1 => read ALL lines
+    TOOLS::MetricsFile m_metrics; // metrics file written in exeFromFile()
+    //
+    // accumulated CPU time per stage
+    clock_t m_clockTabulate; // initTabIntegral()
+    clock_t m_clockBestMu;   // findAllBestMu()
+    clock_t m_clockBelt;     // calcNMin()
+    clock_t m_clockLimit;    // calcLimit()/calcCoverageLimit() minus calcNMin()
+    int     m_nAnalysed;     // number of calls to analyseExperiment()
     //
   };
 
+  void PoleStat::clear() {
+    nAnalysed     = 0;
+    timeTabulate  = 0;
+    timeBestMu    = 0;
+    timeBelt      = 0;
+    timeLimit     = 0;
+    nIntegrations = 0;
+    intBudgetStops = 0;
+    tabBuilds     = 0;
+    tabHits       = 0;
+    tabFallbacks  = 0;
+    tabExtends    = 0;
+    tabDirect     = 0;
+  }
+
+  void PoleStat::add( const PoleStat & other ) {
+    nAnalysed     += other.nAnalysed;
+    timeTabulate  += other.timeTabulate;
+    timeBestMu    += other.timeBestMu;
+    timeBelt      += other.timeBelt;
+    timeLimit     += other.timeLimit;
+    nIntegrations += other.nIntegrations;
+    intBudgetStops += other.intBudgetStops;
+    tabBuilds     += other.tabBuilds;
+    tabHits       += other.tabHits;
+    tabFallbacks  += other.tabFallbacks;
+    tabExtends    += other.tabExtends;
+    tabDirect     += other.tabDirect;
+  }
+
+  void PoleStat::addMetrics( TOOLS::MetricsFile & metrics ) const {
+    metrics.add("analysed",         nAnalysed);
+    metrics.add("time_tabulate_s",  timeTabulate);
+    metrics.add("time_bestmu_s",    timeBestMu);
+    metrics.add("time_belt_s",      timeBelt);
+    metrics.add("time_limit_s",     timeLimit);
+    metrics.add("integrator_calls", nIntegrations);
+    metrics.add("integrator_budget_stops", intBudgetStops);
+    metrics.add("poletab_builds",   tabBuilds);
+    metrics.add("poletab_hits",     tabHits);
+    metrics.add("poletab_fallbacks",tabFallbacks);
+    metrics.add("poletab_extends",  tabExtends);
+    metrics.add("poletab_direct",   tabDirect);
+  }
+
+  void PoleStat::printTabStat() const {
+    printIntStat();
+    if (tabBuilds==0) return;
+    std::cout << ">>>Pole table: lookups = " << tabHits
+              << ", extensions = " << tabExtends
+              << ", out of range = " << tabFallbacks << std::endl;
+    if (tabFallbacks>0) {
+      std::cout << "WARNING: " << tabFallbacks << " values were integrated outside the pole table." << std::endl;
+      std::cout << "         Possible cure: increase the table range (--tabpolenmax, --tabpolesmax) or use --tabgrow." << std::endl;
+    }
+  }
+
+  void PoleStat::printIntStat() const {
+    if (intBudgetStops==0) return;
+    std::cout << "WARNING: " << intBudgetStops << " of " << nIntegrations
+              << " integrals reached --gslintncalls before the tolerance." << std::endl;
+    std::cout << "         Their error is larger than requested; increase --gslintncalls." << std::endl;
+  }
+
   PoleIntegrator::PoleIntegrator() {
     m_poleData.polePtr = 0;
+    m_intType = Integrator::INT_VEGAS;
   }
 
   PoleIntegrator::~PoleIntegrator() {
@@ -693,6 +940,8 @@ namespace LIMITS {
     }
     
     m_integrator.setFunctionParams( &m_poleData );
+    m_integratorQMC.setFunctionParams( &m_poleData );
+    m_integratorCubature.setFunctionParams( &m_poleData );
   }
   void PoleIntegrator::setParameters( std::vector<double> & pars ) {
     // parameter [s_tabNobsInd] = N(obs)
@@ -701,18 +950,78 @@ namespace LIMITS {
     this->m_poleData.signal  = pars[this->m_poleData.polePtr->s_tabSigInd];
   }
 
-  const Integrator *PoleIntegrator::getIntegrator() const { return & m_integrator; }
-  Integrator       *PoleIntegrator::integrator()          { return & m_integrator; }
+  PoleFunPtr PoleIntegrator::selectFunction() { return selectPoleFun( m_poleData ); }
+  PoleFunBatchPtr PoleIntegrator::selectBatchFunction() { return selectPoleFunBatch( m_poleData ); }
+
+  const Integrator *PoleIntegrator::getIntegrator() const {
+    if (m_intType==Integrator::INT_QMC)      return & m_integratorQMC;
+    if (m_intType==Integrator::INT_CUBATURE) return & m_integratorCubature;
+    return & m_integrator;
+  }
+  Integrator       *PoleIntegrator::integrator() {
+    if (m_intType==Integrator::INT_QMC)      return & m_integratorQMC;
+    if (m_intType==Integrator::INT_CUBATURE) return & m_integratorCubature;
+    return & m_integrator;
+  }
+  const IntegratorVegas *PoleIntegrator::getVegas() const { return & m_integrator; }
+  IntegratorVegas       *PoleIntegrator::vegas()          { return & m_integrator; }
+  const IntegratorCubature *PoleIntegrator::getCubature() const { return & m_integratorCubature; }
 
   int    PoleIntegrator::getEffIndex()  const { return m_poleData.effIndex; }
-  double PoleIntegrator::getEffIntMin() const { return (m_poleData.effIndex<0 ? m_poleData.effObs : m_integrator.getIntXmin( m_poleData.effIndex )); }
-  double PoleIntegrator::getEffIntMax() const { return (m_poleData.effIndex<0 ? m_poleData.effObs : m_integrator.getIntXmax( m_poleData.effIndex )); }
+  double PoleIntegrator::getEffIntMin() const { return (m_poleData.effIndex<0 ? m_poleData.effObs : getIntegrator()->getIntXmin( m_poleData.effIndex )); }
+  double PoleIntegrator::getEffIntMax() const { return (m_poleData.effIndex<0 ? m_poleData.effObs : getIntegrator()->getIntXmax( m_poleData.effIndex )); }
   int    PoleIntegrator::getBkgIndex()  const { return m_poleData.bkgIndex; }
-  double PoleIntegrator::getBkgIntMin() const { return (m_poleData.bkgIndex<0 ? m_poleData.bkgObs : m_integrator.getIntXmin( m_poleData.bkgIndex )); }
-  double PoleIntegrator::getBkgIntMax() const { return (m_poleData.bkgIndex<0 ? m_poleData.bkgObs : m_integrator.getIntXmax( m_poleData.bkgIndex )); }
+  double PoleIntegrator::getBkgIntMin() const { return (m_poleData.bkgIndex<0 ? m_poleData.bkgObs : getIntegrator()->getIntXmin( m_poleData.bkgIndex )); }
+  double PoleIntegrator::getBkgIntMax() const { return (m_poleData.bkgIndex<0 ? m_poleData.bkgObs : getIntegrator()->getIntXmax( m_poleData.bkgIndex )); }
   //
-  void   PoleIntegrator::go()           { this->m_integrator.go(); }
-  double PoleIntegrator::result() const { return this->m_integrator.result(); }
+  void   PoleIntegrator::go()           { this->integrator()->go(); }
+  double PoleIntegrator::result() const { return this->getIntegrator()->result(); }
+  bool   PoleIntegrator::isConstant() const { return ((m_poleData.effIndex<0) && (m_poleData.bkgIndex<0)); }
+
+  double PoleIntegrator::getLogValue( int n, double s ) const {
+    // log of poleFun() with eff and bkg at their observed values
+    const PoleData & pd = m_poleData;
+    const double lfe = (pd.pdfEff ? pd.pdfEff->getLogVal(pd.effObs, pd.effObs, pd.deffObs) : 0.0);
+    const double lfb = (pd.pdfBkg ? pd.pdfBkg->getLogVal(pd.bkgObs, pd.bkgObs, pd.dbkgObs) : 0.0);
+    return pd.pdfObs->getLogVal(n, pd.effObs*s + pd.bkgObs) + lfe + lfb;
+  }
+
+  int PoleIntegrator::getColumn( double s, std::vector<double> & p, bool logp ) const {
+    const PoleData & pd = m_poleData;
+    if (pd.pdfObs->getDist()!=PDF::DIST_POIS) return 0;
+    const PDF::Poisson *pois = static_cast<const PDF::Poisson *>(pd.pdfObs);
+    // up to mean + 10 sigma - beyond that, P(n) is negligible
+    const double mean = pd.effObs*s + pd.bkgObs;
+    const int    nn   = static_cast<int>(mean + 10.0*std::sqrt(mean>0.0 ? mean:0.0)) + 20;
+    if (p.size()<static_cast<size_t>(nn)) p.resize(nn);
+    if (logp) {
+      const double lfe = (pd.pdfEff ? pd.pdfEff->getLogVal(pd.effObs, pd.effObs, pd.deffObs) : 0.0);
+      const double lfb = (pd.pdfBkg ? pd.pdfBkg->getLogVal(pd.bkgObs, pd.bkgObs, pd.dbkgObs) : 0.0);
+      pois->getLogColumn(mean, 0, &p[0], nn);
+      for (int i=0; i<nn; i++) p[i] += lfe + lfb;
+    } else {
+      const double fe = (pd.pdfEff ? pd.pdfEff->getVal(pd.effObs, pd.effObs, pd.deffObs) : 1.0);
+      const double fb = (pd.pdfBkg ? pd.pdfBkg->getVal(pd.bkgObs, pd.bkgObs, pd.dbkgObs) : 1.0);
+      pois->getColumn(mean, 0, &p[0], nn);
+      for (int i=0; i<nn; i++) p[i] *= fe*fb;
+    }
+    return nn;
+  }
+
+  void PoleIntegrator::getValues( int n, const double *s, double *p, size_t ns ) {
+    // as poleFun() with eff and bkg at their observed values
+    const PoleData & pd = m_poleData;
+    const double fe = (pd.pdfEff ? pd.pdfEff->getVal(pd.effObs, pd.effObs, pd.deffObs) : 1.0);
+    const double fb = (pd.pdfBkg ? pd.pdfBkg->getVal(pd.bkgObs, pd.bkgObs, pd.dbkgObs) : 1.0);
+    if (m_lambda.size()<ns) m_lambda.resize(ns);
+    for (size_t i=0; i<ns; i++) m_lambda[i] = pd.effObs*s[i] + pd.bkgObs;
+    if (pd.pdfObs->getDist()==PDF::DIST_POIS) {
+      static_cast<const PDF::Poisson *>(pd.pdfObs)->getValsMean(n, &m_lambda[0], p, ns);
+    } else {
+      for (size_t i=0; i<ns; i++) p[i] = pd.pdfObs->getVal(n, m_lambda[i]);
+    }
+    for (size_t i=0; i<ns; i++) p[i] *= fe*fb;
+  }
   
   inline const double Pole::getSbest(int n) const {
     double rval = 0.0;
@@ -749,12 +1058,60 @@ namespace LIMITS {
     return rval;
   }
 
+  //! ln of getLsbest()
+  inline const double Pole::getLogLsbest(int n) const {
+    double rval = 0.0;
+    if (usesMBT()) {
+      double g;
+      if (n>m_measurement.getBkgObs()*m_measurement.getBkgScale()) {
+        g = static_cast<double>(n);
+      } else {
+        g = m_measurement.getBkgObs()*m_measurement.getBkgScale();
+      }
+      rval = m_poisson->getLogVal(n,g);
+    } else {
+      rval = m_logBestMuProb[n];
+    }
+    return rval;
+  }
+
 };
 
 inline double LIMITS::Pole::calcProb( int n, double s ) {
+  double x[2];
+  x[s_tabSigInd]  = s;
+  x[s_tabNobsInd] = static_cast<double>(n);
+  double p;
+  if (m_poleIntFixed.lookup(x,p)) {
+    m_poleIntFixedHits++;
+    return p;
+  }
   m_calcProbBuf[s_tabSigInd] = s;
   m_calcProbBuf[s_tabNobsInd] = static_cast<double>(n);
-  return m_poleIntTable.getValue( m_calcProbBuf );
+  p = m_poleIntTable.getValue( m_calcProbBuf );
+  if (m_poleIntTable.getStatNextend()!=m_poleIntTabExtends) updateTabRange();
+  return p;
+}
+
+inline double LIMITS::Pole::calcLogProb( int n, double s ) {
+  if ((!m_poleIntTable.isTabulated()) && m_poleIntegrator.isConstant()) {
+    return m_poleIntegrator.getLogValue(n,s);
+  }
+  const double p = calcProb(n,s);
+  return (p>0.0 ? std::log(p) : -HUGE_VAL);
+}
+
+inline int LIMITS::Pole::calcProbColumn( double s ) {
+  if (m_poleIntTable.isTabulated() || (!m_poleIntegrator.isConstant())) return 0;
+  return m_poleIntegrator.getColumn(s,m_colProb,m_logLhRatio);
+}
+
+inline void LIMITS::Pole::calcProbs( int n, const double *s, double *p, size_t ns ) {
+  if ((!m_poleIntTable.isTabulated()) && m_poleIntegrator.isConstant()) {
+    m_poleIntegrator.getValues(n,s,p,ns); // no integral - one batch
+  } else {
+    for (size_t i=0; i<ns; i++) p[i] = calcProb(n,s[i]);
+  }
 }
 
 // template<>
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include "Profile.h"
+
+namespace PROF {
+  bool gEnabled = false;
+  __thread StatBlock *gStatBlock = 0;
+
+  namespace {
+    pthread_mutex_t    s_statLock    = PTHREAD_MUTEX_INITIALIZER;
+    StatBlock         *s_statBlocks  = 0; // all blocks, one per thread that used a slot
+    int                s_statNslots  = 0; // number of slots in use
+    const std::string *s_liveName[MAXSTATSLOTS]; // name of the owner, 0 once released
+    // copy of the name after release - plain chars, since pdfs are released during static destruction
+    const int          NAMELEN       = 32;
+    char               s_name[MAXSTATSLOTS][NAMELEN];
+    bool               s_atExit      = false;
+
+    void setName(int slot, const char *name) {
+      strncpy(s_name[slot],name,NAMELEN-1);
+      s_name[slot][NAMELEN-1] = 0;
+    }
+    std::string slotName(int slot) {
+      return (s_liveName[slot] ? *s_liveName[slot] : std::string(s_name[slot]));
+    }
+    void printAtExit() { printSummary(); }
+  };
+
+  int newStatSlot(const std::string *name) {
+    pthread_mutex_lock(&s_statLock);
+    int slot;
+    if (s_statNslots<MAXSTATSLOTS-1) {
+      slot = s_statNslots++;
+      s_liveName[slot] = name;
+    } else {
+      slot = MAXSTATSLOTS-1;
+      s_liveName[slot] = 0;
+      setName(slot,"(others)");
+    }
+    pthread_mutex_unlock(&s_statLock);
+    return slot;
+  }
+
+  void releaseStatSlot(int slot) {
+    pthread_mutex_lock(&s_statLock);
+    if (s_liveName[slot]) {
+      setName(slot,s_liveName[slot]->c_str());
+      s_liveName[slot] = 0;
+    }
+    pthread_mutex_unlock(&s_statLock);
+  }
+
+  // NOTE: the blocks are kept after the thread exits such that its counts are not lost
+  StatBlock *newStatBlock() {
+    StatBlock *block = new StatBlock;
+    pthread_mutex_lock(&s_statLock);
+    block->next  = s_statBlocks;
+    s_statBlocks = block;
+    pthread_mutex_unlock(&s_statLock);
+    return block;
+  }
+
+  // NOTE: counters of running threads are read without synchronisation - fine for statistics
+  void sumStat(int slot, Stat & stat) {
+    stat.clear();
+    pthread_mutex_lock(&s_statLock);
+    for (StatBlock *block = s_statBlocks; block!=0; block = block->next) {
+      stat.add(block->slot[slot]);
+    }
+    pthread_mutex_unlock(&s_statLock);
+  }
+
+  void setEnabled(bool on) {
+    gEnabled = on;
+    if (on && (!s_atExit)) {
+      s_atExit = true;
+      atexit(printAtExit);
+    }
+  }
+
+  void printSummary() {
+    std::cout << "\n";
+    std::cout << "==============P R O F I L E===================\n";
+    std::cout << " Timed calls        : 1 in " << SAMPLEPERIOD << std::endl;
+    std::cout << "----------------------------------------------\n";
+    std::cout << std::left << std::setw(28) << " Name" << std::right
+              << std::setw(14) << "calls"
+              << std::setw(10) << "table"
+              << std::setw(12) << "fallback"
+              << std::setw(14) << "cycles/call" << std::endl;
+    const std::ios_base::fmtflags flags = std::cout.flags();
+    const std::streamsize         prec  = std::cout.precision();
+    Stat stat;
+    for (int i=0; i<MAXSTATSLOTS; i++) {
+      sumStat(i,stat);
+      if (stat.ntot==0) continue;
+      std::cout << " " << std::left << std::setw(27) << slotName(i).substr(0,26) << std::right
+                << std::setw(14) << stat.ntot
+                << std::setw(9)  << std::fixed << std::setprecision(1) << 100.0*stat.tabRatio() << "%"
+                << std::setw(12) << stat.nfallback
+                << std::setw(14) << std::setprecision(1) << stat.cyclesPerCall() << std::endl;
+    }
+    std::cout.flags(flags);
+    std::cout.precision(prec);
+    std::cout << "==============================================\n";
+  }
+};
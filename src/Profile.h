@@ -0,0 +1,128 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+//
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <ctime>
+#endif
+
+/*!
+  Run time profile of the pdfs and of the integrand.
+
+  Off by default, switched on with setEnabled() (option --profile).
+  When off, an instrumented call costs one test of gEnabled.
+  When on, each call is counted in counters owned by the calling thread,
+  and every SAMPLEPERIOD'th call is timed with the cycle counter.
+  A summary table is printed at exit.
+
+  Counters are per (slot,thread) - a slot is allocated per pdf instance, see newStatSlot().
+  Evaluating a pdf must not write shared memory, since the same (global) pdf
+  is used by all threads. The blocks of the threads are summed on demand.
+ */
+namespace PROF {
+  //! true if profiling is on - do not modify directly, use setEnabled()
+  extern bool gEnabled;
+  //! one call in SAMPLEPERIOD is timed
+  const int SAMPLEPERIOD = 64;
+  //! max number of slots - the remaining ones share the last slot
+  const int MAXSTATSLOTS = 64;
+
+  //! usage counters of one pdf
+  struct Stat {
+    unsigned long      ntot;      /**< total number of calls */
+    unsigned long      nraw;      /**< calls using the raw function */
+    unsigned long      nrawCache; /**< calls using a recurrence (PoissonCursor) */
+    unsigned long      ntab;      /**< calls using the table */
+    unsigned long      nfallback; /**< calls outside the table */
+    unsigned long      nsampled;  /**< calls that were timed */
+    unsigned long long cycles;    /**< cycles spent in the timed calls */
+    int                countdown; /**< calls until the next timed one */
+    Stat() { clear(); }
+    void clear() { ntot=0; nraw=0; nrawCache=0; ntab=0; nfallback=0; nsampled=0; cycles=0; countdown=1; }
+    void add(const Stat & other) {
+      ntot      += other.ntot;
+      nraw      += other.nraw;
+      nrawCache += other.nrawCache;
+      ntab      += other.ntab;
+      nfallback += other.nfallback;
+      nsampled  += other.nsampled;
+      cycles    += other.cycles;
+    }
+    //! average cycles per call, 0 if nothing was timed
+    double cyclesPerCall() const { return (nsampled>0 ? static_cast<double>(cycles)/static_cast<double>(nsampled) : 0.0); }
+    //! fraction of calls using the table
+    double tabRatio()      const { return (ntot>0 ? static_cast<double>(ntab)/static_cast<double>(ntot) : 0.0); }
+  };
+  //! counters of all slots for one thread
+  struct StatBlock {
+    Stat       slot[MAXSTATSLOTS];
+    StatBlock *next;
+  };
+
+  //! get a new slot ; name must stay valid until releaseStatSlot()
+  int  newStatSlot(const std::string *name);
+  //! the owner of the slot is destroyed - keeps a copy of its name for the summary
+  void releaseStatSlot(int slot);
+  //! allocate and register a block for the calling thread
+  StatBlock *newStatBlock();
+  //! sum the counters of the given slot over all threads
+  void sumStat(int slot, Stat & stat);
+  //! switch profiling on/off - the summary is printed at exit if it was on at any time
+  void setEnabled(bool on);
+  //! print the summary table of all slots with calls
+  void printSummary();
+
+  extern __thread StatBlock *gStatBlock;
+  //! counters of the given slot for the calling thread
+  inline Stat & threadStat(int slot) {
+    if (gStatBlock==0) gStatBlock = newStatBlock();
+    return gStatBlock->slot[slot];
+  }
+
+  //! cycle counter - ns if not available
+  inline unsigned long long cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return static_cast<unsigned long long>(ts.tv_sec)*1000000000ULL + ts.tv_nsec;
+#endif
+  }
+
+  /*! @class Probe
+
+    @brief Counts n calls in a slot and times them if sampled - place at the start of the scope to measure.
+  */
+  class Probe {
+  public:
+    inline Probe(int slot, unsigned long n=1):m_stat(0),m_timed(false),m_n(0),m_t0(0) {
+      if (!gEnabled) return;
+      m_stat = &threadStat(slot);
+      m_stat->ntot += n;
+      if (--m_stat->countdown>0) return;
+      m_stat->countdown = SAMPLEPERIOD;
+      m_timed = true;
+      m_n     = n;
+      m_t0    = cycles();
+    }
+    inline ~Probe() {
+      if (!m_timed) return;
+      m_stat->cycles   += cycles()-m_t0;
+      m_stat->nsampled += m_n;
+    }
+    //! add n to the given counter of the slot, e.g. count(&Stat::ntab)
+    inline void count(unsigned long Stat::*counter, unsigned long n=1) const {
+      if (m_stat) m_stat->*counter += n;
+    }
+  private:
+    Stat              *m_stat;
+    bool               m_timed;
+    unsigned long      m_n;
+    unsigned long long m_t0;
+  };
+};
+
+#endif
@@ -5,7 +5,37 @@
 namespace RND {
   Random gRandom;
 
+  //
+  // Ziggurat tables (Marsaglia and Tsang, J. Stat. Softw. 5 (2000), as in Doornik's ZIGNOR)
+  // Layer i covers x < s_zigX[i]; s_zigR[i] = s_zigX[i+1]/s_zigX[i] is the fraction of
+  // the layer that is entirely below the pdf. Filled once at startup - read-only afterwards.
+  //
+  namespace {
+    const double ZIGR = 3.442619855899;     // start of the tail
+    const double ZIGV = 9.91256303526217e-3; // area of each layer
+    double s_zigX[ZIGN+1];
+    double s_zigR[ZIGN];
+    struct ZigInit {
+      ZigInit() {
+        double f = std::exp(-0.5*ZIGR*ZIGR);
+        s_zigX[0]    = ZIGV/f; // base layer including the tail
+        s_zigX[1]    = ZIGR;
+        s_zigX[ZIGN] = 0.0;
+        for (int i=2; i<ZIGN; i++) {
+          s_zigX[i] = std::sqrt(-2.0*std::log(ZIGV/s_zigX[i-1] + f));
+          f = std::exp(-0.5*s_zigX[i]*s_zigX[i]);
+        }
+        for (int i=0; i<ZIGN; i++) s_zigR[i] = s_zigX[i+1]/s_zigX[i];
+      }
+    };
+    ZigInit s_zigInit;
+  };
+
   Random::Random(unsigned int seed) {
+    m_engine   = RNG_LCG;
+    m_gaussAlg = GAUSS_BOXMULLER;
+    m_poisMean = -1.0;
+    m_poisNcdf = 0;
     setSeed(seed);
   }
   Random::~Random() {
@@ -25,9 +55,59 @@ namespace RND {
     } else {
       m_seed = seed;
     }
+    if (m_engine==RNG_XOSHIRO) seedXoshiro(m_seed);
+  }
+
+  void Random::setEngine(ENGINE engine) {
+    m_engine = engine;
+    if (m_engine==RNG_XOSHIRO) seedXoshiro(m_seed);
+  }
+
+  void Random::seedXoshiro(unsigned long long key) {
+    for (int i=0; i<4; i++) m_xs[i] = splitMix64(key);
+  }
+
+  void Random::setSubstream(unsigned int seed, unsigned int i1, unsigned int i2) {
+    // always xoshiro - LCG seeds are points on one cycle of ~1e8, hence the streams would overlap
+    m_engine = RNG_XOSHIRO;
+    // key = f(seed,i1,i2) - SplitMix64 scrambles each step, hence nearby indices give unrelated states
+    unsigned long long key = seed;
+    key = splitMix64(key) ^ (static_cast<unsigned long long>(i1) << 32 | i2);
+    key = splitMix64(key);
+    seedXoshiro(key);
+    m_seed = seed;
+  }
+
+  void Random::jumpXoshiro(const unsigned long long *poly) {
+    unsigned long long s[4] = {0,0,0,0};
+    for (int i=0; i<4; i++) {
+      for (int b=0; b<64; b++) {
+        if (poly[i] & (1ULL << b)) {
+          for (int j=0; j<4; j++) s[j] ^= m_xs[j];
+        }
+        nextXoshiro();
+      }
+    }
+    for (int j=0; j<4; j++) m_xs[j] = s[j];
+  }
+
+  void Random::jump() {
+    static const unsigned long long poly[4] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                                0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    if (m_engine==RNG_XOSHIRO) jumpXoshiro(poly);
+  }
+
+  void Random::longJump() {
+    static const unsigned long long poly[4] = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+                                                0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+    if (m_engine==RNG_XOSHIRO) jumpXoshiro(poly);
   }
   
   double Random::rndm() const {
+    if (m_engine==RNG_XOSHIRO) {
+      // upper 53 bits, in ]0,1] as below
+      return static_cast<double>((nextXoshiro() >> 11) + 1)*(1.0/9007199254740992.0);
+    }
     //  Machine independent random number generator.
     //  Produces uniformly-distributed floating points between 0 and 1.
     //  Identical sequence on all machines of >= 32 bits.
@@ -44,44 +124,164 @@ namespace RND {
     return rndm();
   }
   
+  void Random::setupPoisson(double mean) const {
+    if (mean==m_poisMean) return;
+    m_poisMean = mean;
+    if (mean<POISINVMAX) {
+      // cdf up to where it no longer changes
+      double p = std::exp(-mean);
+      double c = p;
+      m_poisCdf[0] = c;
+      m_poisNcdf   = 1;
+      while ((m_poisNcdf<POISCDFN) && (c<1.0)) {
+        p *= mean/static_cast<double>(m_poisNcdf);
+        c += p;
+        m_poisCdf[m_poisNcdf++] = c;
+      }
+    } else {
+      m_ptrsSlam     = std::sqrt(mean);
+      m_ptrsLogLam   = std::log(mean);
+      m_ptrsB        = 0.931 + 2.53*m_ptrsSlam;
+      m_ptrsA        = -0.059 + 0.02483*m_ptrsB;
+      m_ptrsInvAlpha = 1.1239 + 1.1328/(m_ptrsB-3.4);
+      m_ptrsVr       = 0.9277 - 3.6224/(m_ptrsB-2.0);
+    }
+  }
+
+  int Random::poissonInv(double mean) const {
+    // inversion of the cached cdf - one uniform per draw
+    const double u = rndm();
+    for (int n=0; n<m_poisNcdf; n++) {
+      if (u<=m_poisCdf[n]) return n;
+    }
+    // u above the last entry (rounding) - continue the sum
+    int    n = m_poisNcdf-1;
+    double c = m_poisCdf[n];
+    double p = c - (n>0 ? m_poisCdf[n-1]:0.0);
+    while ((u>c) && (p>0.0)) {
+      n++;
+      p *= mean/static_cast<double>(n);
+      c += p;
+    }
+    return n;
+  }
+
+  int Random::poissonPTRS(double mean) const {
+    // Transformed rejection with squeeze, W. Hormann, Insurance: Math. and Econ. 12 (1993) 39
+    // ~1.1 iterations per draw for all means
+    while (true) {
+      const double u  = rndm() - 0.5;
+      const double v  = rndm();
+      const double us = 0.5 - std::fabs(u);
+      const double kd = std::floor((2.0*m_ptrsA/us + m_ptrsB)*u + mean + 0.43);
+      if ((us>=0.07) && (v<=m_ptrsVr)) return static_cast<int>(kd);
+      if ((kd<0) || ((us<0.013) && (v>us))) continue;
+      if ( (std::log(v) + std::log(m_ptrsInvAlpha) - std::log(m_ptrsA/(us*us) + m_ptrsB)) <=
+           (-mean + kd*m_ptrsLogLam - lgamma(kd+1.0)) ) return static_cast<int>(kd);
+    }
+  }
+
   int Random::poisson(double mean) const
   {
     // Generates a random integer N according to a Poisson law.
-    // Coded from Los Alamos report LA-5061-MS
     // Prob(N) = std::exp(-mean)*mean^N/Factorial(N)
+    // Exact for all means; the setup is kept for the next call with the same mean.
     //
     if (mean <= 0) return 0;
-    // use a gaussian approximation for large values of mean
-    if (mean > 88) return static_cast<int>(gauss(0,1)*std::sqrt(mean) + mean +0.5);
-    //
-    int N;
-    double expmean = std::exp(-mean);
-    double pir = 1;
-    N = -1;
-    while(1) {
-      N++;
-      pir *= rndm();
-      if (pir <= expmean) break;
+    setupPoisson(mean);
+    return (mean<POISINVMAX ? poissonInv(mean) : poissonPTRS(mean));
+  }
+
+  void Random::poisson(double mean, int *out, size_t n) const {
+    if (mean <= 0) {
+      for (size_t i=0; i<n; i++) out[i] = 0;
+      return;
+    }
+    setupPoisson(mean);
+    if (mean<POISINVMAX) {
+      for (size_t i=0; i<n; i++) out[i] = poissonInv(mean);
+    } else {
+      for (size_t i=0; i<n; i++) out[i] = poissonPTRS(mean);
     }
-    return N;
   }
   
   double Random::gamma(double mean, double sigma) const {
-    //See algo at http://en.wikipedia.org/wiki/Gamma_distribution#Generating_Gamma_random_variables
-    return 0.0;
+    // Return a number distributed following a gamma with mean and sigma
+    // shape k = mean^2/sigma^2, scale theta = sigma^2/mean
+    if (mean<=0) return 0.0;
+    if (sigma<=0) return mean;
+    const double theta = sigma*sigma/mean;
+    return gammaKT(mean/theta,theta);
+  }
+
+  double Random::gammaKT(double k, double theta) const {
+    // Marsaglia and Tsang, ACM TOMS 26 (2000) 363
+    // For k<1, use G(k) = G(k+1)*U^(1/k)
+    if ((k<=0) || (theta<=0)) return 0.0;
+    if (k<1.0) return gammaKT(k+1.0,theta)*std::pow(rndm(),1.0/k);
+    const double d = k-1.0/3.0;
+    const double c = 1.0/std::sqrt(9.0*d);
+    double x,v,u;
+    while (true) {
+      do {
+        x = gauss();
+        v = 1.0 + c*x;
+      } while (v<=0);
+      v = v*v*v;
+      u = rndm();
+      const double x2 = x*x;
+      if (u < 1.0 - 0.0331*x2*x2) break;                           // squeeze, ~98% accepted
+      if (std::log(u) < 0.5*x2 + d*(1.0 - v + std::log(v))) break;
+    }
+    return d*v*theta;
   }
 
   double Random::gauss(double mean, double sigma) const {
     //      Return a number distributed following a gaussian with mean and sigma
-    
-    double x, y, z, result;
+    return mean + sigma*(m_gaussAlg==GAUSS_ZIGGURAT ? gaussZiggurat() : gaussBoxMuller());
+  }
+
+  void Random::gauss(double mean, double sigma, double *out, size_t n) const {
+    if (m_gaussAlg==GAUSS_ZIGGURAT) {
+      for (size_t i=0; i<n; i++) out[i] = mean + sigma*gaussZiggurat();
+    } else {
+      for (size_t i=0; i<n; i++) out[i] = mean + sigma*gaussBoxMuller();
+    }
+  }
+
+  double Random::gaussBoxMuller() const {
+    double x, y, z;
     
     y = rndm();
     z = rndm();
     x = z * 6.28318530717958623;
-    result = mean + sigma*sin(x)*std::sqrt(-2*std::log(y));
-    
-    return result;
+    return sin(x)*std::sqrt(-2*std::log(y));
+  }
+
+  double Random::gaussZiggurat() const {
+    while (true) {
+      const double u = 2.0*rndm() - 1.0;
+      const int    i = static_cast<int>(rndmInt() >> 25); // layer from the upper 7 bits
+      // inside the rectangle below the pdf - ~99% of the cases
+      if (std::fabs(u) < s_zigR[i]) return u*s_zigX[i];
+      // base layer: tail
+      if (i==0) return gaussZigTail(u<0);
+      // wedge: accept under the pdf
+      const double x  = u*s_zigX[i];
+      const double f0 = std::exp(-0.5*(s_zigX[i]*s_zigX[i] - x*x));
+      const double f1 = std::exp(-0.5*(s_zigX[i+1]*s_zigX[i+1] - x*x));
+      if (f1 + rndm()*(f0-f1) < 1.0) return x;
+    }
+  }
+
+  double Random::gaussZigTail(bool negative) const {
+    // Marsaglia's tail method for x > ZIGR
+    double x, y;
+    do {
+      x = std::log(rndm())/ZIGR;
+      y = std::log(rndm());
+    } while (-2.0*y < x*x);
+    return (negative ? x-ZIGR : ZIGR-x);
   }
   
   double Random::logNormal(double mean, double sigma) const {
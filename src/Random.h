@@ -6,35 +6,135 @@
 #include <iomanip>
 #include <cmath>
 #include <ctime>
+#include <cstddef>
 //
 // Local copy of what we need from TRandom, extended
 //
 namespace RND {
+  /*!
+    Uniform generator used by Random::rndm(). The engines are built into Random and selected
+    with setEngine() - there is no virtual call per number. A new engine is added as a value
+    here with its branch in rndm(), rndmInt() and setSeed(). setSubstream() always uses xoshiro.
+    The LCG stays the default so that existing results reproduce.
+  */
+  enum ENGINE {
+    RNG_LCG=0,  /*!< 32 bit LCG (F. James), period ~1e8 - the original generator */
+    RNG_XOSHIRO /*!< xoshiro256** (Blackman and Vigna), period 2^256-1, with jump-ahead */
+  };
+  //! SplitMix64 - used for seeding and to derive substreams
+  inline unsigned long long splitMix64(unsigned long long & x) {
+    unsigned long long z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+  //! algorithm used by Random::gauss()
+  enum GAUSSALG {
+    GAUSS_BOXMULLER=0, /*!< Box-Muller, one log, sqrt and sin per number */
+    GAUSS_ZIGGURAT     /*!< ziggurat, 128 layers - mostly one multiplication per number */
+  };
+  //! number of ziggurat layers
+  const int ZIGN = 128;
+
+  //! Poisson sampler: inversion below this mean, PTRS above
+  const double POISINVMAX = 10.0;
+  //! max number of cached cdf entries for the inversion
+  const int    POISCDFN   = 48;
+
   class Random {
   protected:
-    mutable unsigned int m_seed;  //Random number generator seed
+    mutable unsigned int m_seed;  //Random number generator seed (LCG: the state)
+    ENGINE               m_engine;   // uniform generator
+    mutable unsigned long long m_xs[4]; // xoshiro256** state
+    GAUSSALG             m_gaussAlg; // algorithm for gauss()
+    //
+    // setup of poisson() for the last mean used - mean is constant within a coverage point
+    //
+    mutable double m_poisMean;             // mean of the cached setup, <0 => none
+    mutable int    m_poisNcdf;             // inversion: number of cdf entries
+    mutable double m_poisCdf[POISCDFN];    // inversion: cdf(n), n=0..m_poisNcdf-1
+    mutable double m_ptrsSlam;             // PTRS: sqrt(mean)
+    mutable double m_ptrsLogLam;           // PTRS: log(mean)
+    mutable double m_ptrsA;                // PTRS: a, b, 1/alpha and v_r
+    mutable double m_ptrsB;
+    mutable double m_ptrsInvAlpha;
+    mutable double m_ptrsVr;
+    //
+    void   setupPoisson(double mean) const;
+    int    poissonInv(double mean) const;
+    int    poissonPTRS(double mean) const;
+    double gaussBoxMuller() const;
+    double gaussZiggurat() const;
+    double gaussZigTail(bool negative) const;
+    void   seedXoshiro(unsigned long long key);
+    inline unsigned long long nextXoshiro() const;
+    void   jumpXoshiro(const unsigned long long *poly);
   public:
     Random(unsigned int seed=65539);
     virtual ~Random();
-    void copy(const Random &rnd) { m_seed = rnd.getSeed(); }
+    void copy(const Random &rnd) {
+      m_seed     = rnd.getSeed();
+      m_engine   = rnd.getEngine();
+      m_gaussAlg = rnd.getGaussAlg();
+      for (int i=0; i<4; i++) m_xs[i] = rnd.m_xs[i];
+    }
     Random & operator=(const Random &rnd) { copy(rnd); return *this; }
     //
     double gauss(double mean=0.0, double sigma=1.0) const;
+    //! fill out[i], i=0..n-1 with N(mean,sigma)
+    void   gauss(double mean, double sigma, double *out, size_t n) const;
     double logNormal(double mean=1.0, double sigma=1.0) const;
     double logNormalLN(double logMean, double logSigma) const;
     int    poisson(double mean) const;
+    //! fill out[i], i=0..n-1 with Poisson(mean)
+    void   poisson(double mean, int *out, size_t n) const;
     double flat(double mean, double sigma=1.0) const;
     double flatRange(double xmin, double xmax) const;
     double gamma(double mean, double sigma) const;
+    double gammaKT(double k, double theta) const;
     double general(int npts, double *x, double xmin, double xmax, double *f, double fmin, double fmax) const;
     //
     const unsigned int getSeed() const {return m_seed;}
+    const ENGINE   getEngine()   const {return m_engine;}
+    const GAUSSALG getGaussAlg() const {return m_gaussAlg;}
+    //! select the engine - it is reseeded with the current seed
+    void   setEngine(ENGINE engine);
+    void   setGaussAlg(GAUSSALG alg) { m_gaussAlg = alg; }
     void   setSeed(unsigned int seed=65539);
+    /*!
+      Seed an independent substream, e.g. for (grid point, chunk of experiments).
+      The stream depends only on the arguments, hence results do not depend on which thread
+      or shard runs it. The engine is set to xoshiro, whatever it was, and the state is derived
+      with SplitMix64 - LCG substreams would be overlapping parts of its short cycle.
+    */
+    void   setSubstream(unsigned int seed, unsigned int i1, unsigned int i2=0);
+    //! xoshiro: advance 2^128 steps - gives up to 2^128 non-overlapping streams
+    void   jump();
+    //! xoshiro: advance 2^192 steps - e.g. one per shard, each then using jump() for threads
+    void   longJump();
     //
     virtual double rndm() const;
+    //! next 32 bit number of the generator - the upper bits are the most random
+    inline unsigned int rndmInt() const {
+      if (m_engine==RNG_XOSHIRO) return static_cast<unsigned int>(nextXoshiro() >> 32);
+      m_seed *= 69069;
+      return m_seed;
+    }
   };
   
   
+  inline unsigned long long Random::nextXoshiro() const {
+    const unsigned long long result = ((m_xs[1]*5) << 7 | (m_xs[1]*5) >> 57)*9;
+    const unsigned long long t = m_xs[1] << 17;
+    m_xs[2] ^= m_xs[0];
+    m_xs[3] ^= m_xs[1];
+    m_xs[1] ^= m_xs[2];
+    m_xs[0] ^= m_xs[3];
+    m_xs[2] ^= t;
+    m_xs[3] = (m_xs[3] << 45) | (m_xs[3] >> 19);
+    return result;
+  }
+  
 #ifndef RANDOM_CXX
   extern Random gRandom;
 #endif
@@ -12,6 +12,24 @@
 #include "Combination.h"
 #include "ITabulator.h"
 
+//! max number of parameters supported by Tabulator<T>::getTabValue()
+const size_t TABMAXDIM = 8;
+//! TabulatorFixed with banded storage: the offset of a node is (line << TABBANDSHIFT) + node in the line
+const unsigned int TABBANDSHIFT = 32;
+/*!
+  Weights of the table nodes along one axis at u = (x-min)/step, for a table with n nodes.
+  Sets the first node and w[0..k-1], and returns k (<=4). See ITabulator::INTERP.
+  Assumes -0.5 <= u < n-0.5.
+*/
+inline int tabAxisWeights( ITabulator::INTERP interp, double u, int n, size_t & first, double *w );
+/*!
+  Idem along the axis of a derivative table (ITabulator::setDerivAxis()), with 3 values per node.
+  Sets the offsets off[0..k-1] of the values from the start of the line, in units of one value,
+  and their weights. stride is the distance between neighbouring nodes along the axis.
+  Returns k (<=4), or 0 if the interpolation does not use the derivatives (then see tabAxisWeights()).
+*/
+inline int tabDerivWeights( ITabulator::INTERP interp, double u, int n, double step, size_t stride, size_t *off, double *w );
+
 /*! @class Tabulator
 
   @brief A class to tabulate a given function
@@ -79,6 +97,8 @@ public:
    inline void setVerbose(bool v);
    //! do the tabulation
    inline void tabulate();
+   //! extend the table such that it includes the given parameters
+   inline bool extendTable( const std::vector<double> & valvec, size_t maxAdd=~static_cast<size_t>(0) );
    //! get the tabulated value with the given parameter vector
    inline double getValue( const std::vector<double> & valvec );
    //! idem for one parameter
@@ -95,14 +115,31 @@ public:
    inline double getTabMax( size_t pind ) const;
    inline double getTabStep( size_t pind ) const;
    inline size_t getTabNsteps( size_t pind ) const;
+   //! distance in the table between neighbouring values of the parameter
+   inline size_t getTabStride( size_t pind ) const;
    //! check if the table is ok
    inline bool isTabulated() const;
+   /*!
+     Interpolated value at x[0..npar-1] using getInterpolation(), with the derivative table
+     along its axis if there is one - as TabulatorFixed::lookup().
+     Returns false if x is outside the table, or if it is not made.
+     Only reads the table, hence it can be used by several threads.
+   */
+   inline bool getTabValue( const double *x, double & val ) const;
 
 
 protected:
    inline void setTabPar( const char *name, int index, double min, double max, double step, size_t nsteps, int parInd=-1 );
    //! initialize table
    inline void initTable();
+   //! make the derivative table if requested, see setDerivAxis()
+   inline void initDerivs();
+   //! convert the table to the storage given by setTabStorage()
+   inline void initCompact();
+   //! remake the double table from the stored one, see setTabStorage()
+   inline void restoreDense();
+   //! value at the given node, whatever the storage
+   inline double tabNode( size_t ind ) const;
    //! sets the parameter values given
    inline void setParameters( const std::vector<double> & valvec );
    //! sets the parameter values given (index)
@@ -125,6 +162,105 @@ protected:
    T  *m_function;    /**< pointer to function class */
 };
 
+//! dense table of values V, for TabFixedSum
+template<class V>
+struct TabDense {
+   const V *values; /**< first value */
+   inline double node( size_t ind ) const { return values[ind]; }
+};
+
+//! banded table of values V (ITabulator::STORE_BAND), for TabFixedSum ; ind = (line << TABBANDSHIFT) + node
+template<class V>
+struct TabBand {
+   const V           *values; /**< band values */
+   const TabBandLine *lines;  /**< band per line */
+   inline double node( size_t ind ) const {
+      const TabBandLine & l = lines[ind >> TABBANDSHIFT];
+      const int           j = static_cast<int>(ind & ((static_cast<size_t>(1) << TABBANDSHIFT)-1));
+      if ((j<l.lo) || (j>=l.hi)) return 0.0;
+      return values[l.off+j];
+   }
+};
+
+/*!
+  Sum over the tensor product of the nodes of the first A parameters, used by TabulatorFixed.
+  Fixed depth such that the loops are unrolled for small A. S is TabDense or TabBand.
+*/
+template<size_t A, class S>
+struct TabFixedSum {
+   static inline double sum( const S & table, size_t base,
+                             const size_t (*off)[4], const int *nw, const double (*w)[4] ) {
+      double s = 0.0;
+      for (int k=0; k<nw[A-1]; k++) s += w[A-1][k]*TabFixedSum<A-1,S>::sum(table,base+off[A-1][k],off,nw,w);
+      return s;
+   }
+};
+template<class S>
+struct TabFixedSum<0,S> {
+   static inline double sum( const S & table, size_t base,
+                             const size_t (*)[4], const int *, const double (*)[4] ) {
+      return table.node(base);
+   }
+};
+
+/*! @class TabulatorFixed
+
+  @brief Lookup in a Tabulator<T> table with D parameters known at compile time
+
+  A read-only view of a table made by Tabulator<T>::tabulate(), for the inner loops.
+  The limits, the inverse steps and the strides are copied by bind(), such that
+  lookup() has fixed size loops, no division and no allocation.
+  If the table has derivatives (ITabulator::setDerivAxis()), they are used for
+  the Taylor and Hermite interpolation along that parameter. Otherwise the table
+  is read in its storage (ITabulator::setTabStorage()).
+  The view must be bound again if the table is remade, and must not outlive it.
+
+  Tabulator<MyFun> myTab;
+  ...
+  myTab.tabulate();
+  TabulatorFixed<MyFun,2> fixed;
+  fixed.bind(myTab);
+  double x[2] = {1.5,2.3};
+  double val;
+  if (!fixed.lookup(x,val)) val = myfun.getVal(x); // outside the table
+ */
+template<class T, size_t D>
+class TabulatorFixed {
+public:
+   inline TabulatorFixed();
+   /*!
+     Bind to the given table; the interpolation is the one of the table unless
+     interp is not INTERP_DEFAULT. Taylor interpolation along the axes in taylorAxes.
+     Returns false (and stays unbound) if the table is not made or has not D parameters.
+   */
+   inline bool bind( const Tabulator<T> & tab,
+                     ITabulator::INTERP interp=ITabulator::INTERP_DEFAULT, unsigned int taylorAxes=~0u );
+   //! release the table
+   inline void unbind() { m_bound=false; }
+   inline bool isBound() const { return m_bound; }
+   /*!
+     Interpolated value at x[0..D-1]. Returns false if not bound or x is outside the table.
+     Only reads the table, hence it can be used by several threads.
+   */
+   inline bool lookup( const double *x, double & val ) const;
+
+private:
+   bool                m_bound;      /**< true if bound to a table */
+   ITabulator::STORAGE m_store;      /**< storage read by lookup() */
+   TabDense<double>    m_table;      /**< the table, or the derivative table */
+   TabDense<float>     m_tableF;     /**< the table, STORE_FLOAT */
+   TabBand<double>     m_band;       /**< the table, STORE_BAND */
+   TabBand<float>      m_bandF;      /**< the table, STORE_BAND_FLOAT */
+   double              m_min[D];     /**< min per parameter */
+   double              m_invStep[D]; /**< 1/step per parameter, 0 if one step only */
+   double              m_uMax[D];    /**< nsteps-0.5 - upper limit of (x-min)/step */
+   double              m_step[D];    /**< step per parameter */
+   int                 m_n[D];       /**< number of steps per parameter */
+   size_t              m_stride[D];  /**< distance in the table between neighbouring steps */
+   ITabulator::INTERP  m_interp[D];  /**< interpolation per parameter */
+   int                 m_derivAxis;  /**< if >=0, m_table is the derivative table along this parameter */
+};
+
 
 #include "Tabulator.icc"
 
@@ -1,3 +1,5 @@
+#include <fstream>
+#include <cstdio>
 #include "Pdf.h"
 #include "Observable.h"
 #include "Tools.h"
@@ -43,6 +45,7 @@ namespace TOOLS {
       case PDF::DIST_GAUS2D:
       case PDF::DIST_GAUS:
       case PDF::DIST_LOGN:
+      case PDF::DIST_GAMMA:
         xmin = mean - scale*sigma;
         xmax = mean + scale*sigma;
         break;
@@ -194,4 +197,30 @@ namespace TOOLS {
     if (norm>0) std::cout << "Per event CPU time used (ms) : " << (dt/norm) << std::endl;
   }
 
+  //
+  // class MetricsFile members
+  //
+  bool MetricsFile::write() {
+    if (!isActive()) return false;
+    time(&m_lastWrite);
+    std::string tstamp;
+    makeTimeStamp( tstamp, m_lastWrite );
+    std::string tmpName = m_fileName + ".tmp";
+    std::ofstream outf( tmpName.c_str() );
+    if (!outf.is_open()) {
+      std::cerr << "WARNING: could not open metrics file <" << tmpName << ">" << std::endl;
+      return false;
+    }
+    outf << "timestamp " << tstamp << "\n";
+    outf << "unixtime "  << static_cast<long>(m_lastWrite) << "\n";
+    outf << "elapsed_s " << getElapsed() << "\n";
+    outf << m_buffer;
+    outf.close();
+    if (std::rename(tmpName.c_str(), m_fileName.c_str())!=0) {
+      std::cerr << "WARNING: could not rename metrics file to <" << m_fileName << ">" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
 };
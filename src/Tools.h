@@ -66,6 +66,45 @@ namespace TOOLS {
     clock_t m_startClock;
     clock_t m_stopClock;
   };
+
+  /*! @class MetricsFile
+
+    @brief A small machine readable status file for long running jobs
+
+    Each write() replaces the file with a list of 'key value' lines.
+    The file is first written to <name>.tmp and then renamed, hence a reader
+    will never see a partially written file.
+
+  */
+  class MetricsFile {
+  public:
+    MetricsFile():m_interval(30),m_startTime(0),m_lastWrite(0) {}
+    ~MetricsFile() {}
+
+    void setFileName(const char *name) { m_fileName = (name ? name:""); }
+    void setInterval(int dt)           { m_interval = (dt>0 ? dt:1); }
+    void start() { time(&m_startTime); m_lastWrite = m_startTime; }
+    void clear() { m_buffer.clear(); }
+    template<typename T> void add(const char *key, T val) {
+      std::ostringstream sstr;
+      sstr << key << " " << val << "\n";
+      m_buffer += sstr.str();
+    }
+    bool write();
+
+    bool   isActive()   const { return (m_fileName.size()>0); }
+    bool   isDue()      const { time_t t; time(&t); return (isActive() && (int(t-m_lastWrite)>=m_interval)); }
+    double getElapsed() const { time_t t; time(&t); return double(t-m_startTime); }
+    const std::string & getFileName() const { return m_fileName; }
+    int    getInterval() const { return m_interval; }
+
+  private:
+    std::string m_fileName;  /**< output file name; empty => inactive */
+    int         m_interval;  /**< minimum time in seconds between two writes */
+    time_t      m_startTime; /**< time of start() */
+    time_t      m_lastWrite; /**< time of last write() */
+    std::string m_buffer;    /**< lines added since clear() */
+  };
 };
 
 void TOOLS::calcFlatRange( double mean, double sigma, double & xmin, double & xmax ) {
@@ -37,10 +37,22 @@ void argsCoverage(Coverage *coverage, LIMITS::Pole *pole, int argc, char *argv[]
     cmd.add(doStats);
     SwitchArg        doFixSig("S","fixsig", "fixed meas. N(observed)",false);
     cmd.add(doFixSig);
+    SwitchArg        doExact("X","exact", "exact coverage if eff and bkg are constant (no pseudo-experiments)",false);
+    cmd.add(doExact);
 
     ValueArg<double> minProb( "","minp",       "minimum probability",false,-1.0,"float",cmd);
+    SwitchArg        logLh(  "","loglh",     "calculate the likelihood ratio in log space",false);
+    cmd.add(logLh);
+    SwitchArg        profile("","profile",   "profile the pdf calls, summary printed at exit",false);
+    cmd.add(profile);
     //
     ValueArg<std::string> dump("","dump",    "dump filename",false,"","string",cmd);
+    ValueArg<std::string> metrics("","metrics", "metrics filename, updated during the run",false,"","string",cmd);
+    ValueArg<int>    metricsDt( "","metricsdt","seconds between metrics updates",false,30,"int",cmd);
+    ValueArg<int>    nThreads(  "","nthreads", "number of threads (<1 => number of cpus)",false,1,"int",cmd);
+    ValueArg<int>    chunkSize( "","chunk",    "experiments per task with threads (0 => automatic)",false,0,"int",cmd);
+    ValueArg<int>    rngEngine( "","rngengine","uniform generator (0 - LCG, 1 - xoshiro256**) ; with threads, always xoshiro256** substreams",false,0,"int",cmd);
+    ValueArg<int>    gaussAlg(  "","gaussalg", "gaussian generator (0 - Box-Muller, 1 - ziggurat)",false,0,"int",cmd);
 
     ValueArg<int>    verboseCov(   "V","verbcov", "verbose coverage",false,0,"int",cmd);
     ValueArg<int>    verbosePol(   "W","verbpol", "verbose pole",    false,0,"int",cmd);
@@ -77,7 +89,11 @@ void argsCoverage(Coverage *coverage, LIMITS::Pole *pole, int argc, char *argv[]
     //
     ValueArg<double> effIntNSigma(  "","effintnsigma","eff num sigma in integral", false,5.0,"float",cmd);
     ValueArg<double> bkgIntNSigma(  "","bkgintnsigma","bkg num sigma in integral", false,5.0,"float",cmd);
+    ValueArg<int>    intType(       "","inttype",     "integrator (0 - Vegas, 1 - randomized QMC, 2 - adaptive cubature)", false,0,"int",cmd);
     ValueArg<int>    gslIntNCalls(  "","gslintncalls","number of calls in GSL integrator", false,100,"int",cmd);
+    ValueArg<int>    gslIntWarm(    "","gslintwarm",  "number of calls on the Vegas grid of the previous integral (0 => new grid each time)", false,0,"int",cmd);
+    ValueArg<double> gslIntWarmChi2("","gslintwarmchi2","max chi2/dof on a reused Vegas grid - above, redo on a new grid", false,2.0,"float",cmd);
+    ValueArg<double> gaussRelErr(   "","gausserr",    "max rel. error of the tabulated gauss, lognormal and gamma (0 => exact)", false,1e-6,"float",cmd);
     //
     ValueArg<double> tabPoleSMin(   "","tabpolesmin", "Pole table: minimum signal", false,0.0,"float",cmd);
     ValueArg<double> tabPoleSMax(   "","tabpolesmax", "Pole table: maximum signal", false,1.0,"float",cmd);
@@ -86,6 +102,13 @@ void argsCoverage(Coverage *coverage, LIMITS::Pole *pole, int argc, char *argv[]
     ValueArg<int>    tabPoleNMax(   "","tabpolenmax", "Pole table: maximum N(obs)", false,10,"int",cmd);
     SwitchArg        tabPole(       "I","poletab",    "Pole table: tabulated",false);
     cmd.add(tabPole);
+    ValueArg<double> tabPoleGrow(   "","tabgrow",     "Pole table: growth when out of range, e.g. 0.25 (0 => integrate directly)", false,0.0,"float",cmd);
+    SwitchArg        tabPoleDeriv(  "","tabderiv",    "Pole table: store the derivatives in s (Taylor/Hermite interpolation)",false);
+    cmd.add(tabPoleDeriv);
+    SwitchArg        tabPoleFloat(  "","tabfloat",    "Pole table: stored in float",false);
+    cmd.add(tabPoleFloat);
+    ValueArg<double> tabPoleBand(   "","tabband",     "Pole table: per N(obs), store only the signals with P > this (0 => all)", false,0.0,"float",cmd);
+    ValueArg<double> tabAuto(       "","tabauto",     "Tables: choose ranges and steps for this relative precision on 1-CL, e.g. 0.001 (0 => use the options above)", false,0.0,"float",cmd);
 
     ValueArg<double> tabPoisMuMin( "","poismumin", "Poisson table: minimum mean value", false,0.0,"float",cmd);
     ValueArg<double> tabPoisMuMax( "","poismumax", "Poisson table: maximum mean value", false,35.0,"float",cmd);
@@ -94,6 +117,7 @@ void argsCoverage(Coverage *coverage, LIMITS::Pole *pole, int argc, char *argv[]
     ValueArg<int>    tabPoisNmax(  "","poisnmax",  "Poisson table: maximum value of N", false,35,"int",cmd);
     SwitchArg        tabPois(     "P","poistab",   "Poisson table: tabulated",false);
     cmd.add(tabPois);
+    ValueArg<int>    tabInterp(   "","tabinterp",  "Table interpolation (0 - default, 1 - nearest, 2 - linear, 3 - Hermite, 4 - Taylor)", false,0,"int",cmd);
 
     cmd.parse(argc,argv);
     //
@@ -131,11 +155,23 @@ void argsCoverage(Coverage *coverage, LIMITS::Pole *pole, int argc, char *argv[]
 
     pole->setIntEffNSigma(effIntNSigma.getValue());
     pole->setIntBkgNSigma(bkgIntNSigma.getValue());
+    pole->setIntType(((intType.getValue()>=0) && (intType.getValue()<=Integrator::INT_CUBATURE)) ?
+                     static_cast<Integrator::TYPE>(intType.getValue()) : Integrator::INT_VEGAS);
     pole->setIntGslNCalls(gslIntNCalls.getValue());
+    pole->setIntGslWarmStart(gslIntWarm.getValue(),gslIntWarmChi2.getValue());
+    PDF::gGaussTab.setMaxRelError(gaussRelErr.getValue());
+    PDF::gGammaTab.setMaxRelError(gaussRelErr.getValue());
     //
     pole->setIntSigRange( tabPoleSMin.getValue(), tabPoleSMax.getValue(), tabPoleSNStep.getValue());
     pole->setIntNobsRange(tabPoleNMin.getValue(), tabPoleNMax.getValue());
     pole->setTabulateIntegral(tabPole.getValue());
+    pole->setTabGrowth(tabPoleGrow.getValue());
+    pole->setTabDerivs(tabPoleDeriv.getValue());
+    if (tabPoleBand.getValue()>0.0) {
+      pole->setTabStorage(tabPoleFloat.getValue() ? ITabulator::STORE_BAND_FLOAT : ITabulator::STORE_BAND, tabPoleBand.getValue());
+    } else {
+      pole->setTabStorage(tabPoleFloat.getValue() ? ITabulator::STORE_FLOAT : ITabulator::STORE_DOUBLE);
+    }
 
     pole->setBSThreshold(threshBS.getValue());
     pole->setPrecThreshold(threshPrec.getValue());
@@ -143,12 +179,29 @@ void argsCoverage(Coverage *coverage, LIMITS::Pole *pole, int argc, char *argv[]
     pole->setHypTestRange(0.0,1.0,0.1);//hypTestMin.getValue(), hypTestMax.getValue(), hypTestStep.getValue());
 
     pole->setMinMuProb(minProb.getValue());
-    //
+    pole->setLogLhRatio(logLh.getValue());
+    PROF::setEnabled(profile.getValue());
+    const ITabulator::INTERP interp = static_cast<ITabulator::INTERP>( (tabInterp.getValue()>=0) && (tabInterp.getValue()<=ITabulator::INTERP_TAYLOR) ? tabInterp.getValue() : 0 );
+    pole->setTabInterpolation(interp);
+    RND::gRandom.setEngine(rngEngine.getValue()==1 ? RND::RNG_XOSHIRO : RND::RNG_LCG);
+    RND::gRandom.setGaussAlg(gaussAlg.getValue()==1 ? RND::GAUSS_ZIGGURAT : RND::GAUSS_BOXMULLER);
+    //
+    // largest N(obs) of the experiments: 3 sigma above the largest true mean
+    const double muTrue  = sMax.getValue()*effMax.getValue()*effScale.getValue() + bkgMax.getValue()*bkgScale.getValue();
+    const int    nobsMax = static_cast<int>(muTrue+3.0*std::sqrt(muTrue)+3.0);
+    const bool   planned = ((tabAuto.getValue()>0.0) && pole->planTabIntegral(tabAuto.getValue(),nobsMax));
     if (tabPois.getValue()) {
       PDF::gPrintStat = false;
       PDF::gPoisson.initTabulator();
-      PDF::gPoisson.setTabMean( tabPoisMuN.getValue(), tabPoisMuMin.getValue(), tabPoisMuMax.getValue() );
-      PDF::gPoisson.setTabN(tabPoisNmin.getValue(),tabPoisNmax.getValue());
+      if (planned) { // same range and resolution in the mean as the integral table
+        const double muMax = pole->getTabMuMax();
+        PDF::gPoisson.setTabMean( static_cast<size_t>(std::ceil(muMax/pole->getTabMuStep()))+1, 0.0, muMax );
+        PDF::gPoisson.setTabN(0,pole->getIntNobsRange()->max());
+      } else {
+        PDF::gPoisson.setTabMean( tabPoisMuN.getValue(), tabPoisMuMin.getValue(), tabPoisMuMax.getValue() );
+        PDF::gPoisson.setTabN(tabPoisNmin.getValue(),tabPoisNmax.getValue());
+      }
+      PDF::gPoisson.setTabInterpolation(interp);
       PDF::gPoisson.tabulate();
       PDF::gPoisson.clrStat();
     }
@@ -159,13 +212,17 @@ void argsCoverage(Coverage *coverage, LIMITS::Pole *pole, int argc, char *argv[]
     //
     coverage->setPole(pole);
     coverage->setDumpBase(dump.getValue().c_str());
+    coverage->setMetricsFile(metrics.getValue().c_str(),metricsDt.getValue());
     coverage->setVerbose(verboseCov.getValue());
+    coverage->setNThreads(nThreads.getValue());
+    coverage->setChunkSize(chunkSize.getValue());
     //
     coverage->collectStats(doStats.getValue());
     coverage->setNloops(nLoops.getValue());
     coverage->setSeed(rSeed.getValue()+rSeedOfs.getValue());
     //
     coverage->setFixedSig(doFixSig.getValue());
+    coverage->setExact(doExact.getValue());
     coverage->setSTrue(sMin.getValue(), sMax.getValue(), sStep.getValue());
     coverage->setEffTrue(effMin.getValue(), effMax.getValue(), effStep.getValue());
     coverage->setBkgTrue(bkgMin.getValue(), bkgMax.getValue(), bkgStep.getValue());
@@ -0,0 +1,110 @@
+//
+// Timing of the pole table lookups for the two memory orders of the table.
+//
+// The table has the layout of Pole::m_poleIntTable, [0] = N(obs) and [1] = signal,
+// filled with P(n|s+b). The lookups follow the two access patterns of Pole:
+//   belt   : fixed s, loop over n      (calcLhRatio)
+//   bestmu : fixed n, scan s           (findBestMu)
+// using TabulatorFixed with the Taylor expansion in s, as Pole::calcProb().
+//
+// g++ -O2 -Isrc tabbench.cxx -Llib -Wl,-rpath,lib -lpolelib -lgsl -lgslcblas -o tabbench   (after make all)
+// ./tabbench [s step]
+//
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <vector>
+#include "Tabulator.h"
+
+struct PoisBkg {
+  double bkg;
+  double getVal( int n, double s ) const {
+    const double mu = s+bkg;
+    return exp(static_cast<double>(n)*log(mu) - mu - lgamma(static_cast<double>(n)+1.0));
+  }
+};
+
+template<>
+inline double Tabulator<PoisBkg>::calcValue() {
+  return m_function->getVal(static_cast<int>(m_parameters[0]+0.5), m_parameters[1]);
+}
+
+const double gSmax = 35.0;
+const int    gNmax = 60;
+
+// calcLhRatio() - for each s, loop over n until the tail is negligible
+double belt( const TabulatorFixed<PoisBkg,2> & tab, double bkg, double ds ) {
+  double sum = 0.0;
+  double x[2];
+  double v;
+  for (double s=0.0; s<gSmax-1.0; s+=ds) {
+    const double mu = s+bkg;
+    const int nmax  = static_cast<int>(mu + 5.0*sqrt(mu) + 5.0);
+    x[1] = s;
+    for (int n=0; (n<=nmax) && (n<gNmax); n++) {
+      x[0] = n;
+      if (tab.lookup(x,v)) sum += v;
+    }
+  }
+  return sum;
+}
+
+// findBestMu() - for each n, scan s over [0.6*(n-b),n-b]
+double bestMu( const TabulatorFixed<PoisBkg,2> & tab, double bkg, int nscan ) {
+  double sum = 0.0;
+  double x[2];
+  double v;
+  for (int n=0; n<gNmax; n++) {
+    double smax = static_cast<double>(n)-bkg;
+    if (smax<0.0) smax = 0.0;
+    const double smin = 0.6*smax;
+    const double ds   = (smax-smin)/static_cast<double>(nscan);
+    x[0] = n;
+    for (int i=0; i<nscan; i++) {
+      x[1] = smin+ds*static_cast<double>(i);
+      if (tab.lookup(x,v)) sum += v;
+    }
+  }
+  return sum;
+}
+
+int main(int argc, char *argv[]) {
+  const double sstep = (argc>1 ? atof(argv[1]) : 0.01);
+  const int    nrep  = 20;
+  PoisBkg fun;
+  fun.bkg = 3.0;
+  const char *orderName[2] = { "N,s (s contiguous)", "s,N (N contiguous)" };
+  std::cout << "Signal step : " << sstep << std::endl;
+  std::cout << std::left << std::setw(22) << "Memory order" << std::right
+            << std::setw(12) << "belt (ms)" << std::setw(12) << "bestmu (ms)" << std::endl;
+  for (int io=0; io<2; io++) {
+    Tabulator<PoisBkg> tab("bench","P(n|s+b)");
+    tab.setFunction(&fun);
+    tab.setTabNPar(2);
+    tab.addTabParStep("Nobs",  0, 0.0, static_cast<double>(gNmax), 1.0,   0);
+    tab.addTabParStep("signal",1, 0.0, gSmax,                      sstep, 1);
+    std::vector<size_t> order(2);
+    order[0] = (io==0 ? 0:1);
+    order[1] = (io==0 ? 1:0);
+    tab.setTabAxisOrder(order);
+    std::cout.setstate(std::ios::failbit); // no table printout
+    tab.tabulate();
+    std::cout.clear();
+    TabulatorFixed<PoisBkg,2> fixed;
+    fixed.bind(tab, ITabulator::INTERP_TAYLOR, 1u<<1);
+    //
+    double chk = 0.0;
+    clock_t t0 = clock();
+    for (int r=0; r<nrep; r++) chk += belt(fixed, fun.bkg, 0.0137*(1.0+0.01*r));
+    clock_t t1 = clock();
+    for (int r=0; r<nrep*50; r++) chk += bestMu(fixed, fun.bkg, 20+r%3);
+    clock_t t2 = clock();
+    std::cout << std::left << std::setw(22) << orderName[io] << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << 1000.0*double(t1-t0)/CLOCKS_PER_SEC
+              << std::setw(12) << 1000.0*double(t2-t1)/CLOCKS_PER_SEC
+              << "   (check " << std::setprecision(6) << chk << ")" << std::endl;
+  }
+  return 0;
+}
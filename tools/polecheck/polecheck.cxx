@@ -0,0 +1,1288 @@
+//
+// Numerical checks of the library - each check compares with a known or an independent result:
+//   coverage    : exact coverage (constant eff and bkg) against the coverage from pseudo-experiments
+//   threads     : coverage independent of the number of threads, and consistent with the serial loop
+//   batch       : batch evaluation of the Poisson and Gauss pdfs against one value at a time,
+//                 and vexp(), vlog() - also in place - against std::exp(), std::log()
+//   column      : Poisson columns and the ln(n!) table against raw() and lgamma()
+//   gausstab    : relative error of the tabulated Gauss against the requested error
+//   shapetab    : relative error of the tabulated LogNormal and Gamma against the requested error
+//   samplers    : moments of the Poisson (inversion, PTRS), Gauss (Box-Muller, ziggurat) and gamma samplers,
+//                 for both engines, and a chi2 of the Poisson samplers
+//   substreams  : chunk substreams are xoshiro whatever the engine, and uncorrelated
+//   table       : error of the table interpolation against the interpolation error bound
+//   fixed       : TabulatorFixed::lookup() against Tabulator::getTabValue()
+//   growth      : a table extended by out-of-range lookups against a table made directly
+//   derivs      : derivative table against the exact derivatives, and its interpolation error
+//   order       : same table values and lookups with either memory order of the parameters
+//   storage     : lookups in the float and banded tables against the double table
+//   planner     : interpolation error of a planned integral table against its error budget
+//   integrators : integrals against known values ; Vegas warm start and re-adaptation,
+//                 QMC randomizations kept by go() ; cubature deterministic and its call budget
+//   limits      : FC limits with constant eff and bkg against a plain construction of the belt
+//
+// polecheck [check ...]   - all checks if none given ; the exit code is the number of failed checks
+//
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include "Pole.h"
+#include "Coverage.h"
+
+namespace {
+  int gNcheck = 0;
+  int gNfail  = 0;
+
+  void report( const std::string & name, bool ok, const std::string & detail ) {
+    gNcheck++;
+    if (!ok) gNfail++;
+    std::cout << (ok ? "  OK   ":"  FAIL ") << std::left << std::setw(36) << name << std::right
+              << " " << detail << std::endl;
+  }
+
+  std::string fmt( const char *label, double val, double ref ) {
+    std::ostringstream os;
+    os << std::setprecision(6) << label << " " << val << " (expected " << ref << ")";
+    return os.str();
+  }
+
+  // no output from the library while running a check
+  class Silence {
+  public:
+    Silence():m_buf(std::cout.rdbuf(0)) {}
+    ~Silence() { std::cout.rdbuf(m_buf); }
+  private:
+    std::streambuf *m_buf;
+  };
+
+  //
+  // coverage of a few points, recorded instead of printed
+  //
+  class CoverageRecord : public Coverage {
+  public:
+    virtual void outputCoverageResult(const int flag=0) {
+      if (flag==0) {
+        coverage.push_back(getCoverage());
+        error.push_back(getErrCoverage());
+      }
+    }
+    std::vector<double> coverage;
+    std::vector<double> error;
+  };
+
+  //
+  // FC, constant eff = 1 and bkg = 2 ; s(true) from smin to smax
+  //
+  void runConstCoverage( CoverageRecord & cov, bool exact, int nloops, double smin, double smax, double sstep ) {
+    LIMITS::Pole pole;
+    pole.initDefault();
+    pole.setMethod(1);
+    pole.setCL(0.9);
+    pole.setBestMuStep(0.01);
+    pole.setEffPdf(1.0,0.0,PDF::DIST_CONST);
+    pole.setEffObs();
+    pole.setBkgPdf(2.0,0.0,PDF::DIST_CONST);
+    pole.setBkgObs();
+    pole.checkEffBkgDists();
+    pole.setTrueSignal(0.0);
+    pole.setTabulateIntegral(false);
+    pole.setNObserved(0);
+    pole.setUseCoverage(true);
+    Silence quiet;
+    pole.initAnalysis();
+    cov.setPole(&pole);
+    cov.collectStats(false);
+    cov.setNloops(nloops);
+    cov.setSeed(4711);
+    cov.setSTrue(smin,smax,sstep);
+    cov.setEffTrue(1.0,1.0,1.0);
+    cov.setBkgTrue(2.0,2.0,1.0);
+    cov.setExact(exact);
+    cov.doLoop();
+  }
+
+  void checkCoverage() {
+    // s+b not integer, and integer - the belt sum used to stop early at the mode of an integer mean
+    const double smin[2]   = { 0.3, 2.0 };
+    const double smax[2]   = { 4.8, 5.0 };
+    const double sstep[2]  = { 1.5, 3.0 };
+    const size_t npts[2]   = { 4, 2 };
+    const char  *name[2]   = { "coverage exact vs generated", "coverage exact vs generated, integer s+b" };
+    for (int k=0; k<2; k++) {
+      CoverageRecord exact, generated;
+      runConstCoverage(exact,true,1,smin[k],smax[k],sstep[k]);
+      runConstCoverage(generated,false,4000,smin[k],smax[k],sstep[k]);
+      const size_t np = exact.coverage.size();
+      bool ok = (np==npts[k]) && (generated.coverage.size()==np);
+      std::ostringstream detail;
+      detail << std::setprecision(4);
+      for (size_t i=0; ok && (i<np); i++) {
+        // the error of the generated coverage is binomial ; the exact one has none
+        ok = (exact.error[i]==0.0) && (std::fabs(exact.coverage[i]-generated.coverage[i])<=4.0*generated.error[i]);
+        detail << exact.coverage[i] << " ~ " << generated.coverage[i] << " ";
+      }
+      report(name[k], ok, detail.str());
+    }
+  }
+
+  //
+  // the points of runConstCoverage(), with threads
+  //
+  void runThreadCoverage( CoverageRecord & cov, int nthreads ) {
+    LIMITS::Pole pole;
+    pole.initDefault();
+    pole.setMethod(1);
+    pole.setCL(0.9);
+    pole.setBestMuStep(0.01);
+    pole.setEffPdf(1.0,0.0,PDF::DIST_CONST);
+    pole.setEffObs();
+    pole.setBkgPdf(2.0,0.0,PDF::DIST_CONST);
+    pole.setBkgObs();
+    pole.checkEffBkgDists();
+    pole.setTrueSignal(0.0);
+    pole.setTabulateIntegral(false);
+    pole.setNObserved(0);
+    pole.setUseCoverage(true);
+    Silence quiet;
+    pole.initAnalysis();
+    cov.setPole(&pole);
+    cov.collectStats(false);
+    cov.setNloops(4000);
+    cov.setSeed(4711);
+    cov.setSTrue(0.3,4.8,1.5);
+    cov.setEffTrue(1.0,1.0,1.0);
+    cov.setBkgTrue(2.0,2.0,1.0);
+    cov.setNThreads(nthreads);
+    cov.setChunkSize(250);
+    cov.doLoop();
+  }
+
+  void checkThreads() {
+    CoverageRecord serial, two, four;
+    runThreadCoverage(serial,1);
+    runThreadCoverage(two,2);
+    runThreadCoverage(four,4);
+    const size_t np = serial.coverage.size();
+    bool ok = (np==4) && (two.coverage.size()==np) && (four.coverage.size()==np);
+    std::ostringstream detail;
+    detail << std::setprecision(4);
+    for (size_t i=0; ok && (i<np); i++) {
+      ok = (two.coverage[i]==four.coverage[i]);
+      detail << two.coverage[i] << (ok ? " == ":" != ") << four.coverage[i] << " ";
+    }
+    // the seed of a chunk depends only on the seed, the point and the chunk
+    report("threads 2 vs 4 identical", ok, detail.str());
+    if (!ok) return;
+    detail.str("");
+    ok = true;
+    for (size_t i=0; i<np; i++) {
+      // the serial loop draws from the global generator - agreement within the errors
+      const double err = std::sqrt(serial.error[i]*serial.error[i]+two.error[i]*two.error[i]);
+      ok = ok && (std::fabs(serial.coverage[i]-two.coverage[i])<=4.0*err);
+      detail << serial.coverage[i] << " ~ " << two.coverage[i] << " ";
+    }
+    report("threads serial vs threaded", ok, detail.str());
+  }
+
+  //
+  // relative difference of v to ref ; values below DBL_MIN may be flushed to 0
+  //
+  bool closeTo( double v, double ref, double tol, double & maxRel ) {
+    if (std::fabs(ref)>=DBL_MIN) maxRel = std::max(maxRel,std::fabs(v/ref-1.0));
+    return std::fabs(v-ref)<=tol*std::fabs(ref)+DBL_MIN;
+  }
+
+  std::string fmtRel( double maxRel ) {
+    std::ostringstream os;
+    os << "max rel. difference " << std::setprecision(3) << maxRel;
+    return os.str();
+  }
+
+  void checkBatch() {
+    const double tol = 1e-12;
+    const PDF::Poisson & pois = PDF::gPoisson;
+    //
+    // Poisson::getVals() - N = 0..nmax at fixed mean, including mean = 0
+    //
+    const int nmax = 400;
+    std::vector<int>    nv(nmax+1);
+    std::vector<double> out(nmax+1);
+    for (int i=0; i<=nmax; i++) nv[i] = i;
+    const double means[5] = { 0.0, 0.3, 7.5, 150.0, 2000.0 };
+    bool   ok     = true;
+    double maxRel = 0.0;
+    for (int j=0; j<5; j++) {
+      pois.getVals(&nv[0],means[j],0.0,&out[0],nv.size());
+      for (int i=0; i<=nmax; i++) ok = closeTo(out[i],pois.raw(i,means[j]),tol,maxRel) && ok;
+    }
+    report("batch poisson getVals", ok, fmtRel(maxRel));
+    //
+    // Poisson::getValsMean() - means from -1 to 600 at fixed N
+    //
+    std::vector<double> mu(1000);
+    out.resize(mu.size());
+    for (size_t i=0; i<mu.size(); i++) mu[i] = -1.0+0.601*static_cast<double>(i);
+    const int nobs[5] = { 0, 1, 5, 40, 300 };
+    ok     = true;
+    maxRel = 0.0;
+    for (int j=0; j<5; j++) {
+      pois.getValsMean(nobs[j],&mu[0],&out[0],mu.size());
+      for (size_t i=0; i<mu.size(); i++) ok = closeTo(out[i],pois.raw(nobs[j],mu[i]),tol,maxRel) && ok;
+    }
+    report("batch poisson getValsMean", ok, fmtRel(maxRel));
+    //
+    // Gauss::getVals() - 40 sigma on both sides
+    //
+    std::vector<double> x(1000);
+    out.resize(x.size());
+    for (size_t i=0; i<x.size(); i++) x[i] = 1.5-80.0+0.16*static_cast<double>(i);
+    PDF::gGauss.getVals(&x[0],1.5,2.0,&out[0],x.size());
+    ok     = true;
+    maxRel = 0.0;
+    for (size_t i=0; i<x.size(); i++) ok = closeTo(out[i],PDF::gGauss.getVal(x[i],1.5,2.0),tol,maxRel) && ok;
+    report("batch gauss getVals", ok, fmtRel(maxRel));
+    //
+    // FMATH::vexp() and vlog() against std::exp() and std::log(), including the values outside
+    // the kernels - into another array and in place
+    //
+    const double inf = HUGE_VAL;
+    const double nan = std::sqrt(-1.0);
+    const double xexp[11] = { 0.5, -3.0, 700.0, 709.5, 710.0, 1000.0, -800.0, -720.0, inf, -inf, nan };
+    const double xlog[11] = { 0.5, 3.0, 1e300, 0.0, -1.0, 1e-310, inf, -inf, nan, DBL_MIN, DBL_MAX };
+    const char  *fname[2] = { "vexp", "vlog" };
+    for (int f=0; f<2; f++) {
+      const double *xv = (f==0 ? xexp : xlog);
+      std::vector<double> xin(201), y(xin.size()), yin(xin.size());
+      for (size_t i=0; i<xin.size(); i++) xin[i] = xv[(7*i)%11]*(1.0+1e-3*static_cast<double>(i%5));
+      yin = xin;
+      if (f==0) {
+        FMATH::vexp(&xin[0],&y[0],xin.size());
+        FMATH::vexp(&yin[0],&yin[0],yin.size());
+      } else {
+        FMATH::vlog(&xin[0],&y[0],xin.size());
+        FMATH::vlog(&yin[0],&yin[0],yin.size());
+      }
+      ok     = true;
+      maxRel = 0.0;
+      for (size_t i=0; i<xin.size(); i++) {
+        const double ref = (f==0 ? std::exp(xin[i]) : std::log(xin[i]));
+        for (int k=0; k<2; k++) {
+          const double v = (k==0 ? y[i] : yin[i]);
+          if (std::fabs(ref)<DBL_MAX) ok = closeTo(v,ref,1e-14,maxRel) && ok;
+          else                        ok = ((v==ref) || ((v!=v) && (ref!=ref))) && ok; // inf or NaN
+        }
+      }
+      report(std::string("batch ")+fname[f]+" separate and in place", ok, fmtRel(maxRel));
+    }
+  }
+
+  void checkColumn() {
+    const PDF::Poisson & pois = PDF::gPoisson;
+    //
+    // ln(n!) - in the table and above it
+    //
+    bool   ok     = true;
+    double maxRel = 0.0;
+    const int nfac[6] = { 0, 1, 10, 500, PDF::gLogFactorial.getNmax(), 3*PDF::gLogFactorial.getNmax() };
+    for (int i=0; i<6; i++) ok = closeTo(PDF::gLogFactorial(nfac[i]),lgamma(nfac[i]+1.0),1e-14,maxRel) && ok;
+    report("column ln(n!)", ok, fmtRel(maxRel));
+    //
+    // getColumn() and getLogColumn() - N = nmin..nmin+399 ; the recurrence adds one rounding per N
+    //
+    const int    nn       = 400;
+    const int    nmins[2] = { 0, 100 };
+    const double means[5] = { 0.0, 0.3, 7.5, 150.0, 2000.0 };
+    std::vector<double> col(nn);
+    ok     = true;
+    maxRel = 0.0;
+    bool   okLog     = true;
+    double maxRelLog = 0.0;
+    for (int k=0; k<2; k++) {
+      for (int j=0; j<5; j++) {
+        pois.getColumn(means[j],nmins[k],&col[0],nn);
+        for (int i=0; i<nn; i++) ok = closeTo(col[i],pois.raw(nmins[k]+i,means[j]),1e-11,maxRel) && ok;
+        pois.getLogColumn(means[j],nmins[k],&col[0],nn);
+        for (int i=0; i<nn; i++) {
+          const double ref = pois.getLogVal(nmins[k]+i,means[j]);
+          if (std::isinf(ref)) {
+            okLog = okLog && (col[i]==ref);
+          } else {
+            okLog = closeTo(col[i],ref,1e-13,maxRelLog) && okLog;
+          }
+        }
+      }
+    }
+    report("column poisson getColumn", ok, fmtRel(maxRel));
+    report("column poisson getLogColumn", okLog, fmtRel(maxRelLog));
+  }
+
+  void checkGaussTab() {
+    const PDF::GaussTab::INTERP interp[2] = { PDF::GaussTab::INTERP_LINEAR, PDF::GaussTab::INTERP_HERMITE };
+    const char *interpName[2] = { "linear", "Hermite" };
+    const double errs[3] = { 1e-4, 1e-6, 1e-8 };
+    PDF::GaussTab tab(&PDF::gGauss);
+    for (int i=0; i<2; i++) {
+      for (int j=0; j<3; j++) {
+        tab.setInterpolation(interp[i]);
+        tab.setMaxRelError(errs[j]);
+        const int    npts = 400000;
+        const double mumax = tab.getMuMax();
+        double maxErr = 0.0;
+        for (int k=0; k<npts; k++) {
+          const double mu  = mumax*(static_cast<double>(k)+0.5)/static_cast<double>(npts);
+          const double ref = PDF::gGauss.phi(mu);
+          const double err = std::fabs(tab.getVal(mu,0.0,1.0)/ref-1.0);
+          if (err>maxErr) maxErr = err;
+        }
+        std::ostringstream name, detail;
+        name << "gausstab " << interpName[i] << " " << errs[j];
+        detail << "max rel. error " << std::setprecision(3) << maxErr;
+        report(name.str(), maxErr<=errs[j], detail.str());
+      }
+    }
+  }
+
+  //
+  // largest relative error of the tabulated pdf against the exact one, for x = (0,xmax]
+  //
+  template <class T, class E>
+  double maxRelError( const T & tab, const E & exact, double mean, double sigma, double xmax ) {
+    const int npts = 200000;
+    double maxRel = 0.0;
+    for (int k=0; k<npts; k++) {
+      const double x = xmax*(static_cast<double>(k)+0.5)/static_cast<double>(npts);
+      closeTo(tab.getVal(x,mean,sigma),exact.getVal(x,mean,sigma),0.0,maxRel);
+    }
+    return maxRel;
+  }
+
+  void checkShapeTab() {
+    const double errs[2]   = { 1e-6, 1e-8 };
+    const double sigmas[3] = { 0.6, 0.2, 0.05 }; // gamma k = 2.8, 25, 400
+    PDF::LogNormal logn;
+    PDF::Gamma     gamma;
+    PDF::GaussTab  gtab0(&PDF::gGauss);
+    PDF::GaussTab  gtab1(&PDF::gGauss);
+    PDF::GaussTab *gtab[2] = { &gtab0, &gtab1 };
+    PDF::GammaTab  gammaTab[2];
+    for (int j=0; j<2; j++) {
+      gtab[j]->setMaxRelError(errs[j]);
+      gammaTab[j].setMaxRelError(errs[j]);
+      PDF::LogNormalTab lognTab(gtab[j]);
+      for (int i=0; i<3; i++) {
+        const double xmax = 1.0+12.0*sigmas[i];
+        const double errLogn  = maxRelError(lognTab,logn,1.0,sigmas[i],xmax);
+        const double errGamma = maxRelError(gammaTab[j],gamma,1.0,sigmas[i],xmax);
+        std::ostringstream name, detail;
+        name << "shapetab lognormal s=" << sigmas[i] << " " << errs[j];
+        detail << "max rel. error " << std::setprecision(3) << errLogn;
+        report(name.str(), errLogn<=errs[j], detail.str());
+        name.str("");
+        detail.str("");
+        name << "shapetab gamma s=" << sigmas[i] << " " << errs[j];
+        detail << "max rel. error " << std::setprecision(3) << errGamma;
+        report(name.str(), errGamma<=errs[j], detail.str());
+      }
+    }
+    //
+    // the cached shapes follow the settings: the same pdf reconfigured, and a new pdf
+    // at the address of a deleted one
+    //
+    PDF::GammaTab reused;
+    double errReused[2];
+    for (int j=0; j<2; j++) {
+      reused.setMaxRelError(errs[j]);
+      errReused[j] = maxRelError(reused,gamma,1.0,0.05,1.6);
+    }
+    const double ymax = reused.getShape(1.0,0.05).ymax;
+    reused.setNSigma(4.0);
+    const double ymaxNarrow = reused.getShape(1.0,0.05).ymax;
+    std::ostringstream detail;
+    detail << std::setprecision(3) << "max rel. error " << errReused[0] << ", " << errReused[1]
+           << " ; ymax " << ymax << " -> " << ymaxNarrow << " at nsigma 4";
+    report("shapetab gamma reconfigured", (errReused[0]<=errs[0]) && (errReused[1]<=errs[1]) && (ymaxNarrow<ymax),
+           detail.str());
+    double errScoped[2];
+    for (int j=0; j<2; j++) {
+      PDF::GammaTab scoped;
+      scoped.setMaxRelError(errs[j]);
+      errScoped[j] = maxRelError(scoped,gamma,1.0,0.05,1.6);
+    }
+    detail.str("");
+    detail << std::setprecision(3) << "max rel. error " << errScoped[0] << ", " << errScoped[1];
+    report("shapetab gamma new pdf", (errScoped[0]<=errs[0]) && (errScoped[1]<=errs[1]), detail.str());
+  }
+
+  //
+  // mean and variance of n samples, compared with the expected values within nsig standard errors
+  // mu4 is the fourth central moment, for the standard error of the variance
+  //
+  void checkMoments( const std::string & name, const std::vector<double> & x,
+                     double mean, double var, double mu4, double nsig=5.0 ) {
+    const double n = static_cast<double>(x.size());
+    double s1 = 0.0;
+    for (size_t i=0; i<x.size(); i++) s1 += x[i];
+    const double m = s1/n;
+    double s2 = 0.0;
+    for (size_t i=0; i<x.size(); i++) s2 += (x[i]-m)*(x[i]-m);
+    const double v = s2/(n-1.0);
+    const double errMean = std::sqrt(var/n);
+    const double errVar  = std::sqrt((mu4-var*var)/n);
+    report(name+" mean",     std::fabs(m-mean)<nsig*errMean, fmt("mean",m,mean));
+    report(name+" variance", std::fabs(v-var)<nsig*errVar,   fmt("var",v,var));
+  }
+
+  //
+  // chi2 of a Poisson sample against the pmf, cells with >= 20 expected entries, the tails summed
+  //
+  void checkPoissonChi2( const std::string & name, const std::vector<int> & x, double mean ) {
+    const double n = static_cast<double>(x.size());
+    const int nmax = static_cast<int>(mean+10.0*std::sqrt(mean)+10.0);
+    std::vector<double> obs(nmax+1,0.0);
+    for (size_t i=0; i<x.size(); i++) obs[(x[i]>nmax ? nmax:x[i])] += 1.0;
+    double chi2  = 0.0;
+    int    ndof  = -1;
+    double cexp  = 0.0;
+    double cobs  = 0.0;
+    double cum   = 0.0;
+    for (int k=0; k<=nmax; k++) {
+      const double p = (k<nmax ? std::exp(static_cast<double>(k)*std::log(mean)-mean-lgamma(k+1.0)) : 1.0-cum);
+      cum  += p;
+      cexp += n*p;
+      cobs += obs[k];
+      if ((cexp>=20.0) && (n*(1.0-cum)>=20.0 || k==nmax)) {
+        chi2 += (cobs-cexp)*(cobs-cexp)/cexp;
+        ndof++;
+        cexp = 0.0;
+        cobs = 0.0;
+      }
+    }
+    std::ostringstream os;
+    os << "chi2/ndof " << std::setprecision(4) << chi2 << "/" << ndof;
+    report(name+" chi2", (ndof>0) && (std::fabs(chi2-ndof)<5.0*std::sqrt(2.0*ndof)), os.str());
+  }
+
+  void checkSamplers() {
+    const size_t n = 200000;
+    const RND::ENGINE engines[2]    = { RND::RNG_LCG, RND::RNG_XOSHIRO };
+    const char       *engineName[2] = { "LCG", "xoshiro" };
+    for (int e=0; e<2; e++) {
+      RND::Random rnd(12345);
+      rnd.setEngine(engines[e]);
+      const std::string tag = std::string(" [")+engineName[e]+"]";
+      std::vector<double> x(n);
+      //
+      // Poisson: inversion below POISINVMAX, PTRS above ; var = mean, mu4 = mean*(1+3*mean)
+      //
+      const double pmeans[3] = { 3.0, 25.0, 400.0 };
+      for (int j=0; j<3; j++) {
+        const double lam = pmeans[j];
+        std::vector<int> k(n);
+        rnd.poisson(lam,&k[0],n);
+        for (size_t i=0; i<n; i++) x[i] = static_cast<double>(k[i]);
+        std::ostringstream os;
+        os << "poisson(" << lam << (lam<RND::POISINVMAX ? ",inv)":",PTRS)") << tag;
+        checkMoments(os.str(), x, lam, lam, lam*(1.0+3.0*lam));
+        checkPoissonChi2(os.str(), k, lam);
+      }
+      //
+      // Gauss: var = s^2, mu4 = 3*s^4 ; also the fraction beyond 3 sigma (ziggurat tail)
+      //
+      const RND::GAUSSALG algs[2]    = { RND::GAUSS_BOXMULLER, RND::GAUSS_ZIGGURAT };
+      const char         *algName[2] = { "Box-Muller", "ziggurat" };
+      for (int a=0; a<2; a++) {
+        rnd.setGaussAlg(algs[a]);
+        rnd.gauss(1.0,2.0,&x[0],n);
+        const std::string name = std::string("gauss(")+algName[a]+")"+tag;
+        checkMoments(name, x, 1.0, 4.0, 48.0);
+        double ntail = 0.0;
+        for (size_t i=0; i<n; i++) if (std::fabs(x[i]-1.0)>6.0) ntail += 1.0;
+        const double ptail = erfc(3.0/std::sqrt(2.0));
+        const double etail = n*ptail;
+        report(name+" tail >3 sigma", std::fabs(ntail-etail)<5.0*std::sqrt(etail), fmt("entries",ntail,etail));
+      }
+      rnd.setGaussAlg(RND::GAUSS_BOXMULLER);
+      //
+      // gamma(mean,sigma): k = (mean/sigma)^2, theta = sigma^2/mean ; mu4 = 3k(k+2)theta^4
+      //
+      const double gsig[2] = { 0.1, 0.6 };
+      for (int j=0; j<2; j++) {
+        const double mean  = 1.0;
+        const double sigma = gsig[j];
+        for (size_t i=0; i<n; i++) x[i] = rnd.gamma(mean,sigma);
+        const double k     = (mean/sigma)*(mean/sigma);
+        const double theta = sigma*sigma/mean;
+        std::ostringstream os;
+        os << "gamma(1," << sigma << ")" << tag;
+        checkMoments(os.str(), x, mean, sigma*sigma, 3.0*k*(k+2.0)*std::pow(theta,4.0));
+      }
+    }
+  }
+
+};
+
+//
+// table of f(x,y) = sin(x)*cos(y) - all derivatives are bounded by 1
+//
+struct SinCos {
+  double getVal( double x, double y ) const { return std::sin(x)*std::cos(y); }
+};
+
+template<>
+inline double Tabulator<SinCos>::calcValue() {
+  return m_function->getVal(m_parameters[0], m_parameters[1]);
+}
+
+//
+// a ridge f(x,y) = exp(-(y-x)^2/(2*0.3^2)) - one peak along y, for the banded storage
+//
+struct Ridge {
+  double getVal( double x, double y ) const { return std::exp(-0.5*(y-x)*(y-x)/(0.3*0.3)); }
+};
+
+template<>
+inline double Tabulator<Ridge>::calcValue() {
+  return m_function->getVal(m_parameters[0], m_parameters[1]);
+}
+
+namespace {
+  void checkTable() {
+    SinCos fun;
+    const double h = 0.05;
+    Tabulator<SinCos> tab("sincos","sin(x)*cos(y)");
+    tab.setFunction(&fun);
+    tab.setTabNPar(2);
+    tab.addTabParStep("x", 0, 0.0, 3.0, h, 0);
+    tab.addTabParStep("y", 1, 0.0, 3.0, h, 1);
+    {
+      Silence quiet;
+      tab.tabulate();
+    }
+    //
+    // bounds, with |f''| and |f'''| <= 1 :
+    //   multilinear           : h^2/8 per axis
+    //   Taylor, 3 nodes about the nearest one : h^3/16 per axis, the second axis
+    //                                           times the Lebesgue constant 1.25
+    //
+    const ITabulator::INTERP interp[2] = { ITabulator::INTERP_LINEAR, ITabulator::INTERP_TAYLOR };
+    const char *interpName[2]  = { "linear", "Taylor" };
+    const double bound[2]      = { 2.0*h*h/8.0, 2.25*h*h*h/16.0 };
+    for (int i=0; i<2; i++) {
+      tab.setInterpolation(interp[i]);
+      double maxErr  = 0.0;
+      double maxNode = 0.0;
+      // inside, one step from the edges - the edges use one sided nodes
+      for (int ix=0; ix<200; ix++) {
+        for (int iy=0; iy<200; iy++) {
+          const double x[2] = { h+(3.0-2.0*h)*(ix+0.37)/200.0, h+(3.0-2.0*h)*(iy+0.71)/200.0 };
+          double v;
+          if (!tab.getTabValue(x,v)) {
+            maxErr = HUGE_VAL;
+            continue;
+          }
+          const double err = std::fabs(v-fun.getVal(x[0],x[1]));
+          if (err>maxErr) maxErr = err;
+        }
+      }
+      for (int ix=1; ix<59; ix++) {
+        const double x[2] = { ix*h, (60-ix)*h };
+        double v;
+        if (tab.getTabValue(x,v)) {
+          const double err = std::fabs(v-fun.getVal(x[0],x[1]));
+          if (err>maxNode) maxNode = err;
+        } else {
+          maxNode = HUGE_VAL;
+        }
+      }
+      std::ostringstream detail;
+      detail << std::setprecision(3) << "max error " << maxErr << " (bound " << bound[i] << ")";
+      report(std::string("table ")+interpName[i], maxErr<=bound[i], detail.str());
+      detail.str("");
+      detail << std::setprecision(3) << "max error " << maxNode;
+      report(std::string("table ")+interpName[i]+" at nodes", maxNode<1e-12, detail.str());
+    }
+  }
+
+  //
+  // TabulatorFixed::lookup() against Tabulator::getTabValue() on the same table
+  //
+  void checkFixed() {
+    SinCos fun;
+    const double h = 0.05;
+    Tabulator<SinCos> tab("sincos","sin(x)*cos(y)");
+    tab.setFunction(&fun);
+    tab.setTabNPar(2);
+    tab.addTabParStep("x", 0, 0.0, 3.0, h, 0);
+    tab.addTabParStep("y", 1, 0.0, 3.0, h, 1);
+    {
+      Silence quiet;
+      tab.tabulate();
+    }
+    const ITabulator::INTERP interp[4] = { ITabulator::INTERP_NEAREST, ITabulator::INTERP_LINEAR,
+                                           ITabulator::INTERP_HERMITE, ITabulator::INTERP_TAYLOR };
+    const char *interpName[4] = { "nearest", "linear", "Hermite", "Taylor" };
+    for (int i=0; i<4; i++) {
+      tab.setInterpolation(interp[i]);
+      TabulatorFixed<SinCos,2> fixed;
+      bool   ok     = fixed.bind(tab);
+      double maxDif = 0.0;
+      // the whole table, edges included, and a margin outside
+      for (int ix=0; ix<150 && ok; ix++) {
+        for (int iy=0; iy<150 && ok; iy++) {
+          const double x[2] = { -0.2+3.4*(ix+0.37)/150.0, -0.2+3.4*(iy+0.71)/150.0 };
+          double vt=0, vf=0;
+          const bool inTab   = tab.getTabValue(x,vt);
+          const bool inFixed = fixed.lookup(x,vf);
+          if (inTab!=inFixed) ok = false;
+          else if (inTab && std::fabs(vt-vf)>maxDif) maxDif = std::fabs(vt-vf);
+        }
+      }
+      std::ostringstream detail;
+      detail << std::setprecision(3) << "max difference " << maxDif;
+      report(std::string("fixed ")+interpName[i], ok && (maxDif<1e-14), detail.str());
+    }
+  }
+
+  //
+  // growth of a table on out-of-range lookups: the extended table against a table made directly
+  //
+  void checkGrowth() {
+    SinCos fun;
+    const double h = 0.05;
+    std::vector<double> par(2);
+    //
+    // 21x21 nodes ; x=1.3 needs x up to node 26, plus 25% of 21 => 32x21 nodes, 231 new ones
+    //
+    const size_t nadd = 32*21-21*21;
+    for (int imax=0; imax<2; imax++) {
+      const size_t maxSize = (imax==0 ? (1<<20) : 600);
+      Tabulator<SinCos> tab("sincos","sin(x)*cos(y)");
+      tab.setFunction(&fun);
+      tab.setTabNPar(2);
+      tab.addTabParStep("x", 0, 0.0, 1.0, h, 0);
+      tab.addTabParStep("y", 1, 0.0, 1.0, h, 1);
+      tab.setInterpolation(ITabulator::INTERP_LINEAR);
+      tab.setGrowth(0.25,maxSize);
+      {
+        Silence quiet;
+        tab.tabulate();
+      }
+      tab.clrStat();
+      bool   exact = true;
+      size_t nfallbackAtExtend = 0;
+      for (size_t i=0; i<nadd+10; i++) {
+        par[0] = 1.3;
+        par[1] = 0.5;
+        double v;
+        {
+          Silence quiet;
+          v = tab.getValue(par);
+        }
+        if (tab.getStatNextend()==0) exact = exact && (v==fun.getVal(par[0],par[1]));
+        else if (nfallbackAtExtend==0) nfallbackAtExtend = tab.getStatNfallback();
+      }
+      // below min: never extended
+      par[0] = -0.5;
+      {
+        Silence quiet;
+        for (size_t i=0; i<nadd+10; i++) tab.getValue(par);
+      }
+      std::ostringstream detail;
+      if (imax==0) {
+        Tabulator<SinCos> ref("sincos","sin(x)*cos(y)");
+        ref.setFunction(&fun);
+        ref.setTabNPar(2);
+        ref.addTabParStep("x", 0, 0.0, 31*h, h, 0);
+        ref.addTabParStep("y", 1, 0.0, 1.0, h, 1);
+        {
+          Silence quiet;
+          ref.tabulate();
+        }
+        const std::vector<double> & vt = tab.getTabValues();
+        const std::vector<double> & vr = ref.getTabValues();
+        bool same = (vt.size()==vr.size()) && (tab.getTabNsteps(0)==32) && (tab.getTabNsteps(1)==21);
+        for (size_t i=0; same && (i<vt.size()); i++) same = (vt[i]==vr[i]);
+        detail << "extensions " << tab.getStatNextend() << ", fallbacks before " << nfallbackAtExtend
+               << " (expected " << nadd-1 << "), x max " << tab.getTabMax(0);
+        report("growth extension", exact && (tab.getStatNextend()==1) && (nfallbackAtExtend==nadd-1), detail.str());
+        report("growth values", same, "extended table against a table of the same range");
+      } else {
+        detail << "extensions " << tab.getStatNextend() << ", fallbacks " << tab.getStatNfallback();
+        report("growth max size", exact && (tab.getStatNextend()==0) && (tab.getTabNsteps(0)==21), detail.str());
+      }
+    }
+  }
+
+  //
+  // derivative table: the derivatives against the exact ones, and the interpolation with them
+  //
+  void checkDerivs() {
+    SinCos fun;
+    const double h = 0.05;
+    const int    n = 61;
+    Tabulator<SinCos> tab("sincos","sin(x)*cos(y)");
+    tab.setFunction(&fun);
+    tab.setTabNPar(2);
+    tab.addTabParStep("x", 0, 0.0, 3.0, h, 0);
+    tab.addTabParStep("y", 1, 0.0, 3.0, h, 1);
+    tab.setDerivAxis(0);
+    {
+      Silence quiet;
+      tab.tabulate();
+    }
+    //
+    // f' and f'' along x, bounds with |f^(k)|<=1 :
+    //   inside, 4th order             : h^4/30 and h^4/90
+    //   next to the ends, 2nd order   : h^2/6  and h^2/12
+    //   at the ends, one sided        : h^2/3  and h
+    // (leading terms - with a margin for the next ones)
+    //
+    const std::vector<double> & d = tab.getTabDerivs();
+    double maxErr[3][2] = { {0.0,0.0}, {0.0,0.0}, {0.0,0.0} }; // [inside/next to end/end][f'/f'']
+    bool   okSize = (d.size()==3*tab.getTabValues().size());
+    for (int ix=0; okSize && (ix<n); ix++) {
+      for (int iy=0; iy<n; iy++) {
+        const size_t ind = ix*tab.getTabStride(0)+iy*tab.getTabStride(1);
+        const double x = ix*h;
+        const double y = iy*h;
+        const int    k = ((ix>=2) && (ix<n-2) ? 0 : ((ix>=1) && (ix<n-1) ? 1:2));
+        okSize = okSize && (d[3*ind]==tab.getTabValues()[ind]);
+        maxErr[k][0] = std::max(maxErr[k][0], std::fabs(d[3*ind+1]-std::cos(x)*std::cos(y)));
+        maxErr[k][1] = std::max(maxErr[k][1], std::fabs(d[3*ind+2]+std::sin(x)*std::cos(y)));
+      }
+    }
+    const double h2 = h*h;
+    const double h4 = h2*h2;
+    const double derivBound[3][2] = { {1.1*h4/30.0,1.1*h4/90.0}, {1.1*h2/6.0,1.1*h2/12.0}, {1.1*h2/3.0,1.1*h} };
+    const char  *derivName[3]     = { "inside", "next to the ends", "at the ends" };
+    std::ostringstream detail;
+    for (int k=0; k<3; k++) {
+      detail.str("");
+      detail << std::setprecision(3) << "f' " << maxErr[k][0] << " (bound " << derivBound[k][0]
+             << "), f'' " << maxErr[k][1] << " (bound " << derivBound[k][1] << ")";
+      report(std::string("derivs ")+derivName[k],
+             okSize && (maxErr[k][0]<=derivBound[k][0]) && (maxErr[k][1]<=derivBound[k][1]), detail.str());
+    }
+    //
+    // interpolation along x at the y nodes, where y does not contribute ;
+    // bounds with exact derivatives: Hermite h^4/384, Taylor (h/2)^3/6 - with a margin for the differences
+    //
+    const ITabulator::INTERP interp[2] = { ITabulator::INTERP_HERMITE, ITabulator::INTERP_TAYLOR };
+    const char *interpName[2]  = { "Hermite", "Taylor" };
+    const double bound[2]      = { 1.1*h4/384.0, 1.1*h2*h/48.0 };
+    for (int i=0; i<2; i++) {
+      tab.setInterpolation(interp[i]);
+      TabulatorFixed<SinCos,2> fixed;
+      bool   ok      = fixed.bind(tab);
+      double maxDiff = 0.0;
+      for (int ix=0; ok && (ix<600); ix++) {
+        for (int iy=0; iy<n; iy+=3) {
+          const double x[2] = { 2.0*h+(3.0-4.0*h)*(ix+0.37)/600.0, iy*h };
+          double v;
+          if (!fixed.lookup(x,v)) {
+            ok = false;
+            break;
+          }
+          maxDiff = std::max(maxDiff, std::fabs(v-fun.getVal(x[0],x[1])));
+        }
+      }
+      detail.str("");
+      detail << std::setprecision(3) << "max error " << maxDiff << " (bound " << bound[i] << ")";
+      report(std::string("derivs ")+interpName[i], ok && (maxDiff<=bound[i]), detail.str());
+      //
+      // getValue() reads the same derivative table as the lookup - anywhere in the table
+      //
+      double maxAgree = 0.0;
+      for (int j=0; ok && (j<2000); j++) {
+        const double x[2] = { 3.0*((j*0.618034)-std::floor(j*0.618034)), 3.0*((j*0.754878)-std::floor(j*0.754878)) };
+        double v, vt;
+        if ((!fixed.lookup(x,v)) || (!tab.getTabValue(x,vt))) {
+          ok = false;
+          break;
+        }
+        maxAgree = std::max(maxAgree, std::max(std::fabs(vt-v), std::fabs(tab.getValue(std::vector<double>(x,x+2))-v)));
+      }
+      detail.str("");
+      detail << std::setprecision(3) << "max difference to TabulatorFixed " << maxAgree;
+      report(std::string("derivs ")+interpName[i]+" getValue", ok && (maxAgree<=1e-14), detail.str());
+    }
+  }
+
+  //
+  // memory order of the parameters: same values with either order
+  //
+  void checkAxisOrder() {
+    SinCos fun;
+    const double h = 0.05;
+    Tabulator<SinCos> tabPar("sincos","sin(x)*cos(y)");
+    Tabulator<SinCos> tabRev("sincos","sin(x)*cos(y)");
+    Tabulator<SinCos> *tab[2] = { &tabPar, &tabRev };
+    std::vector<size_t> order(2);
+    order[0] = 1;
+    order[1] = 0;
+    bool okOrder = true;
+    for (int i=0; i<2; i++) {
+      tab[i]->setFunction(&fun);
+      tab[i]->setTabNPar(2);
+      tab[i]->addTabParStep("x", 0, 0.0, 3.0, h, 0);
+      tab[i]->addTabParStep("y", 1, 0.0, 2.0, h, 1);
+      tab[i]->setDerivAxis(1);
+      if (i==1) {
+        Silence quiet;
+        okOrder = tab[i]->setTabAxisOrder(order) && (!tab[i]->setTabAxisOrder(std::vector<size_t>(2,0)));
+      }
+      {
+        Silence quiet;
+        tab[i]->tabulate();
+      }
+    }
+    okOrder = okOrder && (tab[0]->getTabStride(1)==1) && (tab[1]->getTabStride(0)==1) &&
+      (tab[1]->getTabStride(1)==tab[1]->getTabNsteps(0));
+    std::ostringstream detail;
+    detail << "strides x,y : " << tab[0]->getTabStride(0) << "," << tab[0]->getTabStride(1)
+           << " and " << tab[1]->getTabStride(0) << "," << tab[1]->getTabStride(1);
+    report("order strides", okOrder, detail.str());
+    //
+    bool sameNodes = (tab[0]->getTabValues().size()==tab[1]->getTabValues().size());
+    for (size_t ix=0; sameNodes && (ix<tab[0]->getTabNsteps(0)); ix++) {
+      for (size_t iy=0; iy<tab[0]->getTabNsteps(1); iy++) {
+        const size_t i0 = ix*tab[0]->getTabStride(0)+iy*tab[0]->getTabStride(1);
+        const size_t i1 = ix*tab[1]->getTabStride(0)+iy*tab[1]->getTabStride(1);
+        sameNodes = sameNodes && (tab[0]->getTabValues()[i0]==tab[1]->getTabValues()[i1]);
+        for (int k=0; k<3; k++) sameNodes = sameNodes && (tab[0]->getTabDerivs()[3*i0+k]==tab[1]->getTabDerivs()[3*i1+k]);
+      }
+    }
+    report("order nodes", sameNodes, "values and derivatives at the nodes");
+    //
+    const ITabulator::INTERP interp[4] = { ITabulator::INTERP_NEAREST, ITabulator::INTERP_LINEAR,
+                                           ITabulator::INTERP_HERMITE, ITabulator::INTERP_TAYLOR };
+    const char *interpName[4] = { "nearest", "linear", "Hermite", "Taylor" };
+    for (int i=0; i<4; i++) {
+      TabulatorFixed<SinCos,2> fixed[2];
+      bool   ok     = true;
+      for (int j=0; j<2; j++) {
+        tab[j]->setInterpolation(interp[i]);
+        ok = ok && fixed[j].bind(*tab[j]);
+      }
+      double maxDif = 0.0;
+      for (int ix=0; ok && (ix<150); ix++) {
+        for (int iy=0; iy<100; iy++) {
+          const double x[2] = { 3.0*(ix+0.37)/150.0, 2.0*(iy+0.71)/100.0 };
+          double vt[2], vf[2];
+          for (int j=0; j<2; j++) ok = ok && tab[j]->getTabValue(x,vt[j]) && fixed[j].lookup(x,vf[j]);
+          if (!ok) break;
+          maxDif = std::max(maxDif, std::max(std::fabs(vt[0]-vt[1]), std::fabs(vf[0]-vf[1])));
+        }
+      }
+      detail.str("");
+      detail << std::setprecision(3) << "max difference " << maxDif;
+      report(std::string("order ")+interpName[i], ok && (maxDif<1e-15), detail.str());
+    }
+  }
+
+  //
+  // float and banded storage against the double table
+  //
+  void checkStorage() {
+    Ridge fun;
+    const double h         = 0.05;
+    const double threshold = 1e-12;
+    Tabulator<Ridge> ref("ridge","exp(-(y-x)^2/0.18)");
+    ref.setFunction(&fun);
+    ref.setTabNPar(2);
+    ref.addTabParStep("x", 0, 0.0, 5.0, h, 0);
+    ref.addTabParStep("y", 1, 0.0, 5.0, h, 1);
+    {
+      Silence quiet;
+      ref.tabulate();
+    }
+    const size_t denseMemory = ref.getTabMemory();
+    //
+    // max difference: float rounding (2^-24 relative, max |f| = 1) resp. the threshold,
+    // times the sum of |weights| (<=1.25)
+    //
+    const ITabulator::STORAGE storage[3] = { ITabulator::STORE_FLOAT, ITabulator::STORE_BAND, ITabulator::STORE_BAND_FLOAT };
+    const char  *storageName[3] = { "float", "band", "band float" };
+    const double fEps           = 1.0/16777216.0;
+    const double bound[3]       = { 1.25*fEps, 1.25*threshold, 1.25*(fEps+threshold) };
+    const double maxMemory[3]   = { 0.5, 0.75, 0.4 };  // the band is about 2x2.2 of the 5 in y
+    const ITabulator::INTERP interp[4] = { ITabulator::INTERP_NEAREST, ITabulator::INTERP_LINEAR,
+                                           ITabulator::INTERP_HERMITE, ITabulator::INTERP_TAYLOR };
+    for (int is=0; is<3; is++) {
+      Tabulator<Ridge> tab("ridge","exp(-(y-x)^2/0.18)");
+      tab.setFunction(&fun);
+      tab.setTabNPar(2);
+      tab.addTabParStep("x", 0, 0.0, 5.0, h, 0);
+      tab.addTabParStep("y", 1, 0.0, 5.0, h, 1);
+      tab.setTabStorage(storage[is],threshold);
+      {
+        Silence quiet;
+        tab.tabulate();
+      }
+      bool   ok     = tab.getTabValues().empty();
+      double maxDif = 0.0;
+      for (int i=0; ok && (i<4); i++) {
+        ref.setInterpolation(interp[i]);
+        tab.setInterpolation(interp[i]);
+        TabulatorFixed<Ridge,2> fixedRef, fixed;
+        ok = fixedRef.bind(ref) && fixed.bind(tab);
+        for (int ix=0; ok && (ix<100); ix++) {
+          for (int iy=0; iy<100; iy++) {
+            const double x[2] = { 5.0*(ix+0.37)/100.0, 5.0*(iy+0.71)/100.0 };
+            double vr, vt, vf;
+            ok = ref.getTabValue(x,vr) && tab.getTabValue(x,vt) && fixed.lookup(x,vf);
+            if (!ok) break;
+            fixedRef.lookup(x,vr);
+            maxDif = std::max(maxDif, std::max(std::fabs(vt-vr), std::fabs(vf-vr)));
+          }
+        }
+      }
+      const double memRatio = static_cast<double>(tab.getTabMemory())/static_cast<double>(denseMemory);
+      std::ostringstream detail;
+      detail << std::setprecision(3) << "max difference " << maxDif << " (bound " << bound[is]
+             << "), memory " << memRatio << " of double";
+      report(std::string("storage ")+storageName[is], ok && (maxDif<=bound[is]) && (memRatio<=maxMemory[is]), detail.str());
+    }
+  }
+
+  //
+  // planned integral table: the interpolation error summed over N, between the s nodes,
+  // against the budget prec*(1-CL)
+  //
+  void checkPlanner() {
+    const double prec[2] = { 0.01, 0.001 };
+    double       step[2] = { 0.0, 0.0 };
+    for (int ip=0; ip<2; ip++) {
+      LIMITS::Pole pole;
+      pole.initDefault();
+      pole.setMethod(1);
+      pole.setCL(0.9);
+      pole.setEffPdf(1.0,0.0,PDF::DIST_CONST);
+      pole.setEffObs();
+      pole.setBkgPdf(2.37,0.0,PDF::DIST_CONST);
+      pole.setBkgObs();
+      pole.checkEffBkgDists();
+      pole.setNObserved(5);
+      bool ok;
+      {
+        Silence quiet;
+        ok = pole.planTabIntegral(prec[ip]);
+        pole.initAnalysis();
+      }
+      const Range<double> *sr = pole.getIntSigRange();
+      const Range<int>    *nr = pole.getIntNobsRange();
+      step[ip] = sr->step();
+      double maxSum = 0.0;
+      for (int is=0; ok && (is<sr->n()-1); is++) {
+        const double s   = sr->getVal(is)+0.5*sr->step();
+        double       sum = 0.0;
+        for (int n=nr->min(); n<=nr->max(); n++) {
+          double err;
+          sum += std::fabs(pole.calcProb(n,s)-pole.calcProbDirect(n,s,err));
+        }
+        if (sum>maxSum) maxSum = sum;
+      }
+      const double budget = prec[ip]*(1.0-0.9);
+      std::ostringstream name, detail;
+      name << "planner prec " << prec[ip];
+      detail << std::setprecision(3) << "step " << step[ip] << " ; max error summed over N " << maxSum
+             << " (budget " << budget << ")";
+      report(name.str(), ok && (maxSum<=budget), detail.str());
+    }
+    std::ostringstream detail;
+    detail << std::setprecision(3) << "steps " << step[0] << " and " << step[1];
+    report("planner step", step[1]<step[0], detail.str());
+  }
+
+  //
+  // integrators against known integrals
+  //
+  double gauss2D( double *x, size_t, void *params ) {
+    if (params) (*static_cast<unsigned long *>(params))++; // call counter
+    const double c = 0.5/M_PI;
+    return c*std::exp(-0.5*(x[0]*x[0]+x[1]*x[1]))*(1.0+0.3*x[0]);
+  }
+
+  double sine1D( double *x, size_t, void * ) {
+    return std::sin(x[0]);
+  }
+
+  void gauss2DBatch( double *x, size_t npts, size_t dim, void *params, double *fval ) {
+    for (size_t i=0; i<npts; i++) fval[i] = gauss2D(&x[i*dim],dim,params);
+  }
+
+  void checkIntegrator( const std::string & name, Integrator & integ, size_t dim, double (*f)(double *, size_t, void *),
+                        double lo, double hi, double exact, unsigned int ncalls, double nsig, double tol ) {
+    std::vector<double> xl(dim,lo);
+    std::vector<double> xu(dim,hi);
+    integ.setFunction(f);
+    integ.setFunctionDim(dim);
+    integ.setFunctionParams(0);
+    integ.setIntRanges(xl,xu);
+    integ.setNcalls(ncalls);
+    integ.initialize();
+    integ.go();
+    const double diff = std::fabs(integ.result()-exact);
+    std::ostringstream detail;
+    detail << std::setprecision(10) << "result " << integ.result() << " (exact " << exact
+           << ") ; error " << std::setprecision(3) << integ.error();
+    // within nsig estimated errors, and within tol of the exact value
+    report(name, (diff<=nsig*integ.error()+1e-15) && (diff<=tol*exact), detail.str());
+  }
+
+  //
+  // Vegas warm start: go() on the grid of the previous one with fewer calls, a new grid if
+  // the ranges change, and a redo on a new grid if chi2/dof is above the maximum
+  //
+  void checkVegasWarm( const std::string & name, double chisqMax, unsigned long nreadapt, double exact ) {
+    const unsigned int ncalls = 50000;
+    const unsigned int nwarm  = 5000;
+    unsigned long ncall = 0;
+    std::vector<double> xl(2,-4.0);
+    std::vector<double> xu(2,4.0);
+    IntegratorVegas vegas;
+    vegas.setFunction(gauss2D);
+    vegas.setFunctionDim(2);
+    vegas.setFunctionParams(&ncall);
+    vegas.setIntRanges(xl,xu);
+    vegas.setNcalls(ncalls);
+    vegas.setWarmStart(nwarm,chisqMax);
+    vegas.initialize();
+    bool          ok      = true;
+    unsigned long maxWarm = 0;
+    for (int i=0; i<5; i++) {
+      ncall = 0;
+      vegas.go();
+      if (i>0) maxWarm = std::max(maxWarm,ncall);
+      ok = ok && (std::fabs(vegas.result()-exact)<=5.0*vegas.error());
+    }
+    const unsigned long nw = vegas.getNWarm();
+    // new ranges => new grid
+    xl[0] = -5.0;
+    vegas.setIntRanges(xl,xu);
+    vegas.go();
+    std::ostringstream detail;
+    detail << "warm " << nw << " (" << vegas.getNWarm() << " after a range change), readapted " << vegas.getNReadapt()
+           << " ; max calls per warm go() " << maxWarm;
+    ok = ok && (nw==4) && (vegas.getNWarm()==4) && (vegas.getNReadapt()==nreadapt) &&
+      (maxWarm<=(nreadapt>0 ? nwarm+ncalls:nwarm));
+    report(name, ok, detail.str());
+  }
+
+  void checkIntegrators() {
+    const double exact2D = std::pow(erf(4.0/std::sqrt(2.0)),2.0);
+    {
+      IntegratorVegas vegas;
+      checkIntegrator("vegas 2D gauss", vegas, 2, gauss2D, -4.0, 4.0, exact2D, 50000, 5.0, 1e-2);
+      // chi2/dof is >=0 - the first never re-adapts, the second always
+      checkVegasWarm("vegas warm start", HUGE_VAL, 0, exact2D);
+      checkVegasWarm("vegas warm re-adapt", -1.0, 4, exact2D);
+    }
+    {
+      // 8 randomizations - the error estimate has 7 dof, hence the wider margin
+      IntegratorQMC qmc;
+      checkIntegrator("qmc 2D gauss", qmc, 2, gauss2D, -4.0, 4.0, exact2D, 16384, 7.0, 1e-3);
+      IntegratorQMC qmc1;
+      checkIntegrator("qmc 1D sine", qmc1, 1, sine1D, 0.0, M_PI, 2.0, 4096, 7.0, 1e-4);
+      // the randomizations are kept by go(), with or without the batch function
+      const double r0 = qmc.result();
+      qmc.go();
+      const double r1 = qmc.result();
+      qmc.setBatchFunction(gauss2DBatch);
+      qmc.go();
+      const double r2 = qmc.result();
+      std::ostringstream detail;
+      detail << std::setprecision(15) << r0 << " ; " << r1 << " ; batch " << r2;
+      report("qmc repeated go()", (r0==r1) && (r0==r2), detail.str());
+      // more randomizations take effect at the next initialize()
+      qmc.setNShifts(16);
+      qmc.go();
+      const double r3 = qmc.result();
+      detail.str("");
+      detail << std::setprecision(15) << r0 << " ; " << r3 << " after setNShifts(16)";
+      report("qmc setNShifts() before initialize()", r0==r3, detail.str());
+    }
+    {
+      // deterministic - the estimated error is the difference of the embedded rules
+      IntegratorCubature cub;
+      checkIntegrator("cubature 2D gauss", cub, 2, gauss2D, -4.0, 4.0, exact2D, 200000, 1.0, 1e-6);
+      IntegratorCubature cub1;
+      checkIntegrator("cubature 1D sine", cub1, 1, sine1D, 0.0, M_PI, 2.0, 1000, 1.0, 1e-10);
+      IntegratorCubature cubAgain;
+      checkIntegrator("cubature 2D gauss, again", cubAgain, 2, gauss2D, -4.0, 4.0, exact2D, 200000, 1.0, 1e-6);
+      std::ostringstream detail;
+      detail << std::setprecision(15) << cub.result() << " ; " << cubAgain.result();
+      report("cubature deterministic", cub.result()==cubAgain.result(), detail.str());
+      // the tolerance is reached with the budget above, not with the default 100 calls
+      IntegratorCubature cub2;
+      checkIntegrator("cubature 2D gauss, small budget", cub2, 2, gauss2D, -4.0, 4.0, exact2D, 100, 1e9, 1.0);
+      detail.str("");
+      detail << "budget stops: " << cub.getNBudgetStops() << " (200000 calls) ; "
+             << cub2.getNBudgetStops() << " (100 calls)";
+      report("cubature budget stop", (!cub.getBudgetStop()) && cub2.getBudgetStop() &&
+             (cub2.getNBudgetStops()==1), detail.str());
+    }
+  }
+
+  //
+  // Plain FC construction, eff = 1 and known bkg: for each s on a grid, the N are accepted in order
+  // of R = P(N|s+b)/P(N|s_best+b) until the probability sum is >= CL. The limits are the smallest
+  // and largest s where N(obs) is accepted.
+  //
+  double poisson( int n, double mu ) {
+    if (!(mu>0.0)) return (n==0 ? 1.0:0.0);
+    return std::exp(static_cast<double>(n)*std::log(mu)-mu-lgamma(n+1.0));
+  }
+
+  void plainFC( int nobs, double bkg, double cl, double ds, double & lower, double & upper ) {
+    lower = -1.0;
+    upper = -1.0;
+    std::vector< std::pair<double,int> > rank;
+    for (double s=0.0; s<nobs+5.0*std::sqrt(nobs+1.0)+5.0; s+=ds) {
+      const double mu = s+bkg;
+      const int nmax  = static_cast<int>(mu+10.0*std::sqrt(mu)+20.0);
+      rank.clear();
+      for (int n=0; n<nmax; n++) {
+        const double sbest = std::max(0.0,static_cast<double>(n)-bkg);
+        rank.push_back(std::make_pair(-poisson(n,mu)/poisson(n,sbest+bkg),n));
+      }
+      std::sort(rank.begin(),rank.end());
+      double sum = 0.0;
+      bool accepted = false;
+      for (size_t i=0; (i<rank.size()) && (sum<cl); i++) {
+        sum += poisson(rank[i].second,mu);
+        if (rank[i].second==nobs) accepted = true;
+      }
+      if (accepted) {
+        if (lower<0.0) lower = s;
+        upper = s;
+      }
+    }
+  }
+
+  void checkLimits() {
+    const int    nobs[7] = { 5, 15, 8, 2, 5, 7, 3 };
+    const double bkg[7]  = { 2.37, 6.3, 4.6, 0.7, 3.0, 3.0, 1.0 };
+    const double ds      = 0.001;
+    for (int i=0; i<7; i++) {
+      double lower, upper;
+      plainFC(nobs[i],bkg[i],0.9,ds,lower,upper);
+      for (int lg=0; lg<2; lg++) {
+        LIMITS::Pole pole;
+        pole.initDefault();
+        pole.setMethod(1);
+        pole.setCL(0.9);
+        pole.setLogLhRatio(lg==1);
+        pole.setEffPdf(1.0,0.0,PDF::DIST_CONST);
+        pole.setEffObs();
+        pole.setBkgPdf(bkg[i],0.0,PDF::DIST_CONST);
+        pole.setBkgObs();
+        pole.checkEffBkgDists();
+        pole.setNObserved(nobs[i]);
+        pole.setBSThreshold(0.0001);
+        pole.setPrecThreshold(0.000001);
+        pole.setTabulateIntegral(false);
+        bool ok;
+        {
+          Silence quiet;
+          pole.initAnalysis();
+          ok = pole.analyseExperiment();
+        }
+        // the grid of the plain construction gives the limits within ds
+        const double tol = 2.0*ds;
+        ok = ok && (std::fabs(pole.getLowerLimit()-lower)<=tol) && (std::fabs(pole.getUpperLimit()-upper)<=tol);
+        std::ostringstream name, detail;
+        name << "limits n=" << nobs[i] << " b=" << bkg[i] << (lg==1 ? " (log)":"");
+        detail << std::fixed << std::setprecision(4) << "[" << pole.getLowerLimit() << "," << pole.getUpperLimit()
+               << "] (plain FC [" << lower << "," << upper << "])";
+        report(name.str(), ok, detail.str());
+      }
+    }
+  }
+
+
+  //
+  // substreams of the coverage chunks: xoshiro whatever the engine, reproducible, and uncorrelated
+  //
+  void checkSubstreams() {
+    const size_t n       = 20000;
+    const int    nstream = 16;
+    RND::Random lcg(12345);
+    RND::Random xs(12345);
+    lcg.setEngine(RND::RNG_LCG);
+    xs.setEngine(RND::RNG_XOSHIRO);
+    lcg.rndm();
+    lcg.setSubstream(4711,3,7);
+    xs.setSubstream(4711,3,7);
+    bool same = (lcg.getEngine()==RND::RNG_XOSHIRO);
+    for (size_t i=0; same && (i<1000); i++) same = (lcg.rndmInt()==xs.rndmInt());
+    report("substream engine", same, "xoshiro and the same stream whatever the engine before");
+    //
+    // neighbouring chunks: the correlation of u-0.5 between streams, and the means
+    //
+    std::vector< std::vector<double> > u(nstream, std::vector<double>(n));
+    for (int k=0; k<nstream; k++) {
+      RND::Random rnd;
+      rnd.setSubstream(4711,0,k);
+      for (size_t i=0; i<n; i++) u[k][i] = rnd.rndm()-0.5;
+    }
+    // var(u) = 1/12 ; the correlation and sqrt(12 n)*mean are ~N(0,1/n) resp. ~N(0,1)
+    double maxCorr = 0.0;
+    double maxMean = 0.0;
+    for (int k=0; k<nstream; k++) {
+      double m = 0.0;
+      for (size_t i=0; i<n; i++) m += u[k][i];
+      maxMean = std::max(maxMean, std::fabs(m)*std::sqrt(12.0/static_cast<double>(n)));
+      if (k==0) continue;
+      double c = 0.0;
+      for (size_t i=0; i<n; i++) c += u[k][i]*u[k-1][i];
+      maxCorr = std::max(maxCorr, std::fabs(12.0*c/std::sqrt(static_cast<double>(n))));
+    }
+    std::ostringstream detail;
+    detail << std::setprecision(3) << "max |corr| " << maxCorr << " sigma, max |mean| " << maxMean << " sigma";
+    report("substream independence", (maxCorr<4.0) && (maxMean<4.0), detail.str());
+  }
+
+  struct Check {
+    const char *name;
+    void (*run)();
+  };
+};
+
+int main(int argc, char *argv[]) {
+  const Check checks[] = {
+    { "coverage",    checkCoverage },
+    { "threads",     checkThreads },
+    { "batch",       checkBatch },
+    { "column",      checkColumn },
+    { "gausstab",    checkGaussTab },
+    { "shapetab",    checkShapeTab },
+    { "samplers",    checkSamplers },
+    { "substreams",  checkSubstreams },
+    { "table",       checkTable },
+    { "fixed",       checkFixed },
+    { "growth",      checkGrowth },
+    { "derivs",      checkDerivs },
+    { "order",       checkAxisOrder },
+    { "storage",     checkStorage },
+    { "planner",     checkPlanner },
+    { "integrators", checkIntegrators },
+    { "limits",      checkLimits }
+  };
+  const int nchecks = sizeof(checks)/sizeof(Check);
+  for (int i=0; i<nchecks; i++) {
+    bool run = (argc<2);
+    for (int a=1; a<argc; a++) run = run || (std::strcmp(argv[a],checks[i].name)==0);
+    if (!run) continue;
+    std::cout << "--- " << checks[i].name << std::endl;
+    checks[i].run();
+  }
+  std::cout << "=== " << gNcheck-gNfail << " of " << gNcheck << " checks passed" << std::endl;
+  return gNfail;
+}